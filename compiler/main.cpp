@@ -15,7 +15,9 @@
 #include "shared/LILShared.h"
 #include "shared/LILBuildManager.h"
 #include "shared/LILCodeUnit.h"
+#include "shared/LILImportCache.h"
 #include "shared/LILPlatformSupport.h"
+#include "shared/LILServer.h"
 #include "ast/LILRootNode.h"
 
 using namespace LIL;
@@ -24,11 +26,8 @@ const char * versionString =
 #include "../VERSION"
 ;
 
-int main(int argc, const char * argv[]) {
-	if (argc == 1) {
-		return 0;
-	}
-
+int LIL_compile(const std::vector<std::string> & args, const std::string & cwd, const std::string & compilerDir, LILImportCache * importCache)
+{
 	bool verbose = false;
 	bool noConfigureDefaults = false;
 	bool debugConfigureDefaults = false;
@@ -37,19 +36,17 @@ int main(int argc, const char * argv[]) {
 	std::string inName;
 	std::string localDir;
 	std::vector<LILString> arguments;
-	
-	std::string compilerDir = LIL_getExecutableDir();
 
-	for (int i=1, j=argc; i<j; /*intentionally left blank*/) {
-		std::string command = argv[i];
+	for (size_t i=0, j=args.size(); i<j; /*intentionally left blank*/) {
+		const std::string & command = args[i];
 		if (command == "-w"){
 			//set warning levels
-			if (argc<i+1) {
+			if (j<=i+1) {
 				std::cerr << "Error: no warning level given after -w argument\n";
-				exit(-1);
+				return -1;
 			}
 			++i;
-			std::string warningLevelStr = argv[i];
+			std::string warningLevelStr = args[i];
 			std::cerr << "Using warning level "+warningLevelStr;
 			warningLevel = std::stoi(warningLevelStr);
 			++i;
@@ -72,7 +69,7 @@ int main(int argc, const char * argv[]) {
 			
 		} else if (command == "--version") {
 			std::cerr << versionString << "\n";
-			exit(0);
+			return 0;
 			
 		} else if (command.substr(0, 2) == "--") {
 			arguments.push_back(command);
@@ -99,7 +96,6 @@ int main(int argc, const char * argv[]) {
 	}
 	
 	std::string directory;
-	std::string cwd = LIL_getCurrentDir();
 	if (localDir.size() > 0) {
 		directory = localDir;
 	} else {
@@ -127,6 +123,7 @@ int main(int argc, const char * argv[]) {
 	buildMgr->setFile(inName);
 	buildMgr->setCompilerDir(compilerDir);
 	buildMgr->setCurrentWorkingDir(cwd);
+	buildMgr->setImportCache(importCache);
 
 	buildMgr->setNoConfigureDefaults(noConfigureDefaults);
 	buildMgr->setDebugConfigureDefaults(debugConfigureDefaults);
@@ -148,5 +145,57 @@ int main(int argc, const char * argv[]) {
 		std::cerr << "Build errors!\n";
 		return -1;
 	}
-	return 0;
+	//when running in the JIT, this is what the program's main returned
+	return buildMgr->getExitCode();
+}
+
+int main(int argc, const char * argv[]) {
+	if (argc == 1) {
+		return 0;
+	}
+
+	std::string compilerDir = LIL_getExecutableDir();
+	std::string cwd = LIL_getCurrentDir();
+
+	//--server keeps the compiler running, serving builds over a local socket
+	//--connect sends this invocation to a running server instead of building here
+	bool isServer = false;
+	bool isClient = false;
+	bool serverVerbose = false;
+	std::string socketPath = LILServer::getDefaultSocketPath();
+	std::vector<std::string> args;
+	for (int i=1; i<argc; ++i) {
+		std::string command = argv[i];
+		if (command == "--server") {
+			isServer = true;
+		} else if (command == "--connect") {
+			isClient = true;
+		} else if (command.substr(0, 9) == "--socket:") {
+			socketPath = command.substr(9);
+		} else {
+			if (command == "-v" || command == "--verbose") {
+				serverVerbose = true;
+			}
+			args.push_back(command);
+		}
+	}
+
+	if (isServer) {
+		auto importCache = std::make_unique<LILImportCache>();
+		LILServer server;
+		server.setSocketPath(socketPath);
+		server.setVerbose(serverVerbose);
+		server.setImportCache(importCache.get());
+		server.setHandler([&compilerDir, &importCache](const std::vector<std::string> & requestArgs, const std::string & requestCwd) {
+			return LIL_compile(requestArgs, requestCwd, compilerDir, importCache.get());
+		});
+		return server.run();
+	}
+	if (isClient) {
+		LILServer client;
+		client.setSocketPath(socketPath);
+		return client.runClient(args, cwd);
+	}
+
+	return LIL_compile(args, cwd, compilerDir, nullptr);
 }
@@ -427,10 +427,65 @@ void LILASTBuilder::receiveNodeEnd(NodeType nodeType)
 	{
 		this->currentNode = this->currentContainer.back();
 		this->currentContainer.pop_back();
+		if (nodeType == NodeTypeInstruction) {
+			this->applyLoopHint();
+		}
 	}
 	state.pop_back();
 }
 
+//loop hints are stored in the loop that follows them, and the instruction is dropped
+//if it is not followed by a loop it stays in the tree, so that the validator can complain
+void LILASTBuilder::applyLoopHint()
+{
+	auto instr = std::static_pointer_cast<LILInstruction>(this->currentNode);
+	if (!instr->isLoopHint()) {
+		return;
+	}
+	const auto & childNodes = instr->getChildNodes();
+	if (childNodes.size() != 1 || !childNodes.front()->isA(NodeTypeFlowControl)) {
+		return;
+	}
+	auto fc = std::static_pointer_cast<LILFlowControl>(childNodes.front());
+	if (!fc->isA(FlowControlTypeFor) && !fc->isA(FlowControlTypeLoop)) {
+		return;
+	}
+	long int count = -1;
+	const auto & arg = instr->getArgument();
+	if (arg) {
+		if (!arg->isA(NodeTypeNumberLiteral)) {
+			return;
+		}
+		count = std::static_pointer_cast<LILNumberLiteral>(arg)->getValue().toLong();
+		if (count <= 0) {
+			return;
+		}
+	}
+	switch (instr->getInstructionType()) {
+		case InstructionTypeUnroll:
+			fc->setUnrollCount(count);
+			break;
+		case InstructionTypeVectorize:
+			fc->setVectorizeWidth(count);
+			break;
+		case InstructionTypeIndependent:
+			if (arg) {
+				return;
+			}
+			fc->setIsIndependent(true);
+			break;
+		case InstructionTypeParallel:
+			if (arg || !fc->isA(FlowControlTypeFor)) {
+				return;
+			}
+			fc->setIsParallel(true);
+			break;
+		default:
+			break;
+	}
+	this->currentNode = fc;
+}
+
 void LILASTBuilder::receiveNodeCommit()
 {
 	if (this->_debugAST) {
@@ -844,6 +899,19 @@ void LILASTBuilder::receiveNodeCommit()
 					instr->addNode(this->currentNode);
 					break;
 				}
+				case InstructionTypeUnroll:
+				case InstructionTypeVectorize:
+				case InstructionTypeIndependent:
+				case InstructionTypeParallel:
+				{
+					//the count comes first, then the loop
+					if (this->currentNode->isA(NodeTypeFlowControl)) {
+						instr->addNode(this->currentNode);
+					} else {
+						instr->setArgument(this->currentNode);
+					}
+					break;
+				}
 				default:
 				{
 					instr->addNode(this->currentNode);
@@ -1412,6 +1480,14 @@ void LILASTBuilder::receiveNodeData(ParserEvent eventType, const LILString &data
 						instr->setInstructionType(InstructionTypeGPU);
 					} else if (data == "resource") {
 						instr->setInstructionType(InstructionTypeResource);
+					} else if (data == "unroll") {
+						instr->setInstructionType(InstructionTypeUnroll);
+					} else if (data == "vectorize") {
+						instr->setInstructionType(InstructionTypeVectorize);
+					} else if (data == "noalias" || data == "independent") {
+						instr->setInstructionType(InstructionTypeIndependent);
+					} else if (data == "parallel") {
+						instr->setInstructionType(InstructionTypeParallel);
 					}
 					break;
 				}
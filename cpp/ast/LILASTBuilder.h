@@ -106,6 +106,8 @@ namespace LIL
 		bool _verbose;
 		bool _debugAST;
 		bool _buildFlatList;
+
+		void applyLoopHint();
 	};
 }
 
@@ -23,6 +23,11 @@ LILFlowControl::LILFlowControl()
 	this->_receivesFunctionBody = false;
 	this->_receivesElse = false;
 	this->_flowControlType = FlowControlTypeNone;
+	this->_unrollCount = 0;
+	this->_vectorizeWidth = 0;
+	this->_isIndependent = false;
+	this->_isParallel = false;
+	this->_iteratesData = false;
 }
 
 LILFlowControl::LILFlowControl(const LILFlowControl &other)
@@ -35,6 +40,11 @@ LILFlowControl::LILFlowControl(const LILFlowControl &other)
 	this->_receivesElse = other._receivesElse;
 	this->_flowControlType = other._flowControlType;
 	this->_subjectNode = other._subjectNode;
+	this->_unrollCount = other._unrollCount;
+	this->_vectorizeWidth = other._vectorizeWidth;
+	this->_isIndependent = other._isIndependent;
+	this->_isParallel = other._isParallel;
+	this->_iteratesData = other._iteratesData;
 }
 
 std::shared_ptr<LILFlowControl> LILFlowControl::clone() const
@@ -275,3 +285,58 @@ const std::shared_ptr<LILNode> & LILFlowControl::getSubject() const
 {
 	return this->_subjectNode;
 }
+
+void LILFlowControl::setUnrollCount(long int value)
+{
+	this->_unrollCount = value;
+}
+
+long int LILFlowControl::getUnrollCount() const
+{
+	return this->_unrollCount;
+}
+
+void LILFlowControl::setVectorizeWidth(long int value)
+{
+	this->_vectorizeWidth = value;
+}
+
+long int LILFlowControl::getVectorizeWidth() const
+{
+	return this->_vectorizeWidth;
+}
+
+void LILFlowControl::setIsIndependent(bool value)
+{
+	this->_isIndependent = value;
+}
+
+bool LILFlowControl::getIsIndependent() const
+{
+	return this->_isIndependent;
+}
+
+bool LILFlowControl::hasLoopHints() const
+{
+	return this->_unrollCount != 0 || this->_vectorizeWidth != 0 || this->_isIndependent;
+}
+
+void LILFlowControl::setIsParallel(bool value)
+{
+	this->_isParallel = value;
+}
+
+bool LILFlowControl::getIsParallel() const
+{
+	return this->_isParallel;
+}
+
+void LILFlowControl::setIteratesData(bool value)
+{
+	this->_iteratesData = value;
+}
+
+bool LILFlowControl::getIteratesData() const
+{
+	return this->_iteratesData;
+}
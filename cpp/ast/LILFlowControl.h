@@ -54,6 +54,21 @@ namespace LIL
 		void setSubject(std::shared_ptr<LILNode> node);
 		const std::shared_ptr<LILNode> & getSubject() const;
 
+		//loop hints, 0 means no hint, -1 means the hint was given without a count
+		void setUnrollCount(long int value);
+		long int getUnrollCount() const;
+		void setVectorizeWidth(long int value);
+		long int getVectorizeWidth() const;
+		void setIsIndependent(bool value);
+		bool getIsIndependent() const;
+		bool hasLoopHints() const;
+		//#parallel for, the body is run on the thread pool of std/thread.lil
+		void setIsParallel(bool value);
+		bool getIsParallel() const;
+		//for over an object that gives out its elements as one block, see LILForLowerer
+		void setIteratesData(bool value);
+		bool getIteratesData() const;
+
 	protected:
 		virtual std::shared_ptr<LILClonable> cloneImpl() const override;
 		
@@ -65,6 +80,11 @@ namespace LIL
 		bool _receivesFunctionBody;
 		bool _receivesElse;
 		FlowControlType _flowControlType;
+		long int _unrollCount;
+		long int _vectorizeWidth;
+		bool _isIndependent;
+		bool _isParallel;
+		bool _iteratesData;
 	};
 }
 
@@ -106,9 +106,80 @@ void LILFunctionCall::receiveNodeData(const LILString &data)
 	{
 		this->setFunctionCallType(FunctionCallTypeSizeOf);
 	}
+	else if (LILFunctionCall::isSIMDBuiltin(data))
+	{
+		this->setFunctionCallType(FunctionCallTypeSIMD);
+	}
+	else if (LILFunctionCall::isAtomicBuiltin(data))
+	{
+		this->setFunctionCallType(FunctionCallTypeAtomic);
+	}
 	this->_name = data;
 }
 
+bool LILFunctionCall::isSIMDBuiltin(const LILString & name)
+{
+	return name == "simdSplat"
+		|| name == "simdLoad"
+		|| name == "simdStore"
+		|| name == "simdLane"
+		|| name == "simdWithLane"
+		|| name == "simdShuffle"
+		|| name == "simdSelect"
+		|| name == "simdEqual"
+		|| name == "simdLessThan"
+		|| name == "simdGreaterThan"
+		|| name == "simdReduceAdd"
+		|| name == "simdReduceMin"
+		|| name == "simdReduceMax"
+		|| name == "simdFma"
+		|| name == "simdSqrt"
+		|| name == "simdAbs"
+		|| name == "simdMin"
+		|| name == "simdMax"
+	;
+}
+
+bool LILFunctionCall::isAtomicBuiltin(const LILString & name)
+{
+	return name == "atomicLoad"
+		|| name == "atomicStore"
+		|| name == "atomicExchange"
+		|| name == "atomicAdd"
+		|| name == "atomicSub"
+		|| name == "atomicAnd"
+		|| name == "atomicOr"
+		|| name == "atomicXor"
+		|| name == "atomicCompareExchange"
+		|| name == "atomicFence"
+	;
+}
+
+//the arguments before the optional ordering, the address always comes first
+size_t LILFunctionCall::atomicArgumentCount(const LILString & name)
+{
+	if (name == "atomicFence") {
+		return 0;
+	}
+	if (name == "atomicLoad") {
+		return 1;
+	}
+	if (name == "atomicCompareExchange") {
+		return 3;
+	}
+	return 2;
+}
+
+bool LILFunctionCall::isAtomicOrdering(const LILString & name)
+{
+	return name == "relaxed"
+		|| name == "acquire"
+		|| name == "release"
+		|| name == "acq_rel"
+		|| name == "seq_cst"
+	;
+}
+
 FunctionCallType LILFunctionCall::getFunctionCallType() const
 {
 	return this->_functionCallType;
@@ -32,6 +32,10 @@ namespace LIL
 		virtual ~LILFunctionCall();
 
 		void receiveNodeData(const LILString &data) override;
+		static bool isSIMDBuiltin(const LILString & name);
+		static bool isAtomicBuiltin(const LILString & name);
+		static size_t atomicArgumentCount(const LILString & name);
+		static bool isAtomicOrdering(const LILString & name);
 
 		FunctionCallType getFunctionCallType() const override;
 		void setFunctionCallType(FunctionCallType newType);
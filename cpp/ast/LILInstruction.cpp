@@ -65,6 +65,14 @@ LILString LILInstruction::instructionTypeToString(InstructionType instrType)
 			return "expand";
 		case InstructionTypeResource:
 			return "resource";
+		case InstructionTypeUnroll:
+			return "unroll";
+		case InstructionTypeVectorize:
+			return "vectorize";
+		case InstructionTypeIndependent:
+			return "independent";
+		case InstructionTypeParallel:
+			return "parallel";
 		default:
 			return "ERROR: unknown instruction type";
 	}
@@ -154,6 +162,19 @@ bool LILInstruction::getIsColorInstruction() const
 	return this->_isColorInstruction;
 }
 
+bool LILInstruction::isLoopHint() const
+{
+	switch (this->_instructionType) {
+		case InstructionTypeUnroll:
+		case InstructionTypeVectorize:
+		case InstructionTypeIndependent:
+		case InstructionTypeParallel:
+			return true;
+		default:
+			return false;
+	}
+}
+
 void LILInstruction::setArgument(std::shared_ptr<LILNode> value)
 {
 	if (this->_argument) {
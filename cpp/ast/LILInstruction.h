@@ -38,6 +38,7 @@ namespace LIL
 		LILString getName() const;
 		void setIsColorInstruction(bool value);
 		bool getIsColorInstruction() const;
+		bool isLoopHint() const;
 		
 		void setArgument(std::shared_ptr<LILNode> value);
 		std::shared_ptr<LILNode> getArgument() const;
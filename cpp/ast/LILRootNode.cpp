@@ -169,6 +169,10 @@ void LILRootNode::add(std::shared_ptr<LILNode> node, bool addToNodeTree)
 				case InstructionTypeImport:
 				case InstructionTypePaste:
 				case InstructionTypeGetConfig:
+				case InstructionTypeUnroll:
+				case InstructionTypeVectorize:
+				case InstructionTypeIndependent:
+				case InstructionTypeParallel:
 				{
 					if (addToNodeTree) {
 						this->addNode(instr);
@@ -32,11 +32,20 @@
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/Analysis/VectorUtils.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/DiagnosticHandler.h"
+#include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
@@ -45,10 +54,12 @@
 #include "llvm/IR/Verifier.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/InstCombine/InstCombine.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
 #include "llvm/Transforms/Utils/ModuleUtils.h"
+#include "llvm/Transforms/Vectorize.h"
 #include "llvm/AsmParser/Parser.h"
 #include "llvm/AsmParser/LLParser.h"
 
@@ -57,8 +68,10 @@
 
 #define LILIREMITTEROPTIMIZE
 #define LIL_GEP_INDEX_SIZE 32
-#define LIL_ARRAY_SMALL_BUFFER_SIZE 2
 #define LIL_ARRAY_BIG_BUFFER_MIN_SIZE 10
+#define LIL_STRING_SHORT_CAPACITY 47
+//aggregates bigger than two registers are passed and returned through memory, like C does
+#define LIL_ABI_INDIRECT_MIN_SIZE 16
 
 
 using namespace LIL;
@@ -72,11 +85,16 @@ namespace LIL
 		LILIREmitterPrivate(LILString name)
 		: llvmContext()
 		, irBuilder(llvmContext)
+		, llvmModule(name.data(), llvmContext)
 		, needsReturnValue(false)
 		, currentAlloca(nullptr)
 		, returnAlloca(nullptr)
 		, ruleCount(0)
-		, llvmModule(name.data(), llvmContext)
+		, connectedElementCount(1)
+		, domIsStatic(-1)
+		, domMatches(nullptr)
+		, knownDOMMatch(-1)
+		, loopRemarks(false)
 		{
 		}
 		llvm::LLVMContext llvmContext;
@@ -85,6 +103,10 @@ namespace LIL
 		std::unique_ptr<llvm::legacy::FunctionPassManager> functionPassManager;
 		std::map<std::string, llvm::Value*> namedValues;
 		std::vector<std::map<std::string, llvm::Value*>> hiddenLocals;
+		//temporaries created inside each enclosing loop body or branch, ended when it closes
+		std::vector<std::vector<llvm::AllocaInst *>> lifetimeScopes;
+		//start of the elements of each for over an object that iterates its data directly
+		std::map<LILFlowControl *, llvm::Value *> iterationData;
 		std::map<std::string, llvm::StructType *> classTypes;
 		bool needsReturnValue;
 		llvm::Value * currentAlloca;
@@ -92,21 +114,77 @@ namespace LIL
 		llvm::BasicBlock * finallyBB;
 		llvm::BasicBlock * afterLoopBB;
 		int ruleCount;
+		long int connectedElementCount;
+		//whether the rules can only create the elements of the DOM, -1 until checked
+		int domIsStatic;
+		//cleared in LIL__applyRules as soon as an element gets another id than in the DOM
+		llvm::Value * domMatches;
+		//whether the code being emitted is only reached when domMatches is set (1) or cleared (0)
+		int knownDOMMatch;
+		bool loopRemarks;
 		std::shared_ptr<LILElement> dom;
 	};
+
+	//prints what the loop vectorizer and unroller did with each loop
+	class LILLoopRemarkHandler : public llvm::DiagnosticHandler
+	{
+	public:
+		bool isLoopPass(llvm::StringRef passName) const
+		{
+			return passName == "loop-vectorize" || passName == "loop-unroll";
+		}
+		bool isAnalysisRemarkEnabled(llvm::StringRef passName) const override
+		{
+			return this->isLoopPass(passName);
+		}
+		bool isMissedOptRemarkEnabled(llvm::StringRef passName) const override
+		{
+			return this->isLoopPass(passName);
+		}
+		bool isPassedOptRemarkEnabled(llvm::StringRef passName) const override
+		{
+			return this->isLoopPass(passName);
+		}
+		bool isAnyRemarkEnabled() const override
+		{
+			return true;
+		}
+		bool handleDiagnostics(const llvm::DiagnosticInfo & info) override
+		{
+			auto remark = llvm::dyn_cast<llvm::DiagnosticInfoOptimizationBase>(&info);
+			if (!remark || !this->isLoopPass(remark->getPassName())) {
+				return false;
+			}
+			std::cerr << "loop remark in " << remark->getFunction().getName().str() << " (" << remark->getPassName().str() << "): " << remark->getMsg() << "\n";
+			return true;
+		}
+	};
 }
 
 LILIREmitter::LILIREmitter(LILString name)
 : d(new LILIREmitterPrivate(name))
 , _debug(false)
+{
+	this->_createFunctionPassManager(nullptr);
+}
+
+void LILIREmitter::_createFunctionPassManager(llvm::TargetMachine * targetMachine)
 {
 	d->functionPassManager = std::make_unique<llvm::legacy::FunctionPassManager>(&d->llvmModule);
+	//without the target's cost model the vectorizer assumes a target without vector registers
+	if (targetMachine) {
+		d->functionPassManager->add(llvm::createTargetTransformInfoWrapperPass(targetMachine->getTargetIRAnalysis()));
+	}
 	d->functionPassManager->add(llvm::createSROAPass());
+	d->functionPassManager->add(llvm::createMemCpyOptPass());
 	d->functionPassManager->add(llvm::createLICMPass());
 	d->functionPassManager->add(llvm::createDeadCodeEliminationPass());
 	d->functionPassManager->add(llvm::createAggressiveDCEPass());
 	d->functionPassManager->add(llvm::createReassociatePass());
 	d->functionPassManager->add(llvm::createGVNPass());
+	//these only touch loops that carry #vectorize or #unroll hints
+	d->functionPassManager->add(llvm::createLoopVectorizePass(true, true));
+	d->functionPassManager->add(llvm::createLoopUnrollPass(2, true));
 	d->functionPassManager->add(llvm::createCFGSimplificationPass());
 	d->functionPassManager->doInitialization();
 }
@@ -944,10 +1022,13 @@ llvm::Value * LILIREmitter::_emitStr(LILStringLiteral * value)
 		//store the length
 		auto lengthGep = this->_emitGEP(d->currentAlloca, stringTy, true, 0, "length", true, false, 0);
 		d->irBuilder.CreateStore(llvm::ConstantInt::get(llvm::IntegerType::getInt64Ty(d->llvmContext), strLength), lengthGep);
-		if (str.size() > 55) {
+		//a capacity of 0 means the characters are stored inline
+		auto capacityGep = this->_emitGEP(d->currentAlloca, stringTy, true, 2, "capacity", true, false, 0);
+		if (str.size() > LIL_STRING_SHORT_CAPACITY) {
+			d->irBuilder.CreateStore(llvm::ConstantInt::get(llvm::IntegerType::getInt64Ty(d->llvmContext), strLength), capacityGep);
 			std::vector<llvm::Value *> mallocArgs;
 			auto intTy = llvm::IntegerType::get(d->llvmContext, 64);
-			mallocArgs.push_back(llvm::ConstantInt::get(intTy, llvm::APInt(64, strLength, false)));
+			mallocArgs.push_back(llvm::ConstantInt::get(intTy, llvm::APInt(64, strLength+1, false)));
 			auto mallocResult = d->irBuilder.CreateCall(d->llvmModule.getFunction("malloc"), mallocArgs);
 			d->irBuilder.CreateMemCpy(mallocResult, llvm::MaybeAlign(), castedGlobal, llvm::MaybeAlign(), strLength+1);
 			auto bufferGep = this->_emitGEP(d->currentAlloca, stringTy, true, 1, "buffer", true, false, 0);
@@ -955,6 +1036,7 @@ llvm::Value * LILIREmitter::_emitStr(LILStringLiteral * value)
 			d->irBuilder.CreateStore(mallocResult, castedBuffer);
 
 		} else {
+			d->irBuilder.CreateStore(llvm::ConstantInt::get(llvm::IntegerType::getInt64Ty(d->llvmContext), 0), capacityGep);
 			//store the chars
 			auto bufferGep = this->_emitGEP(d->currentAlloca, stringTy, true, 1, "buffer", true, false, 0);
 			auto castedBuffer = d->irBuilder.CreatePointerCast(bufferGep, i8PtrTy);
@@ -1034,7 +1116,22 @@ llvm::Value * LILIREmitter::_emitVarDecl(LILVarDecl * value)
 
 			if (!value->getIsExtern()) {
 				auto initVal = value->getInitVal();
-				if (initVal) {
+				if (initVal && ty->isA(TypeTypeMultiple)) {
+					//the value and its type index are written by a global initializator fn
+					globalVar->setInitializer(llvm::Constant::getNullValue(this->llvmTypeFromLILType(ty.get())));
+					auto ft = llvm::FunctionType::get(llvm::Type::getVoidTy(d->llvmContext), false);
+					llvm::Function * fun = llvm::Function::Create(ft, llvm::Function::ExternalLinkage, name, d->llvmModule);
+					llvm::BasicBlock * bb = llvm::BasicBlock::Create(d->llvmContext, "entry", fun);
+					d->irBuilder.SetInsertPoint(bb);
+					d->currentAlloca = globalVar;
+					auto iv = this->emitForMultipleType(initVal.get(), std::static_pointer_cast<LILMultipleType>(ty));
+					if (iv) {
+						d->irBuilder.CreateStore(iv, globalVar);
+					}
+					d->irBuilder.CreateRetVoid();
+					d->currentAlloca = nullptr;
+					llvm::appendToGlobalCtors(d->llvmModule, fun, 0);
+				} else if (initVal) {
 					switch (initVal->getNodeType()) {
 						case NodeTypeBoolLiteral:
 						{
@@ -1062,6 +1159,12 @@ llvm::Value * LILIREmitter::_emitVarDecl(LILVarDecl * value)
 						case NodeTypeValuePath:
 						case NodeTypeFunctionCall:
 						{
+							//tables made only of literals go straight into the data section
+							auto constInit = this->_emitConstantInitializer(initVal.get(), ty.get());
+							if (constInit) {
+								globalVar->setInitializer(constInit);
+								break;
+							}
 							globalVar->setInitializer(llvm::Constant::getNullValue(this->llvmTypeFromLILType(ty.get())));
 							
 							//create the global initializator fn
@@ -1131,7 +1234,7 @@ llvm::Value * LILIREmitter::_emitVarDecl(LILVarDecl * value)
 							auto valPtrTy = std::static_pointer_cast<LILPointerType>(initVal->getType());
 							llvmValue = d->irBuilder.CreateLoad(this->llvmTypeFromLILType(valPtrTy->getArgument().get()), llvmValue);
 					}
-					d->irBuilder.CreateStore(llvmValue, d->currentAlloca);
+					this->_emitStoreToVariable(llvmValue, d->currentAlloca);
 				}
 			}
 			d->currentAlloca = nullptr;
@@ -1436,7 +1539,7 @@ llvm::Value * LILIREmitter::_emitAsgmt(LILAssignment * asgmt)
 					d->irBuilder.CreateStore(llvmValue, d->currentAlloca);
 				} else {
 					this->_convertLlvmValueIfNeeded(&llvmValue, ty.get(), theValue->getType().get());
-					d->irBuilder.CreateStore(llvmValue, d->currentAlloca);
+					this->_emitStoreToVariable(llvmValue, d->currentAlloca);
 				}
 			}
 			d->currentAlloca = allocaBackup;
@@ -1733,6 +1836,39 @@ llvm::Value * LILIREmitter::_emitAsgmt(LILAssignment * asgmt)
 							}
 							break;
 						}
+						case TypeTypePointer:
+						{
+							//indexing through a pointer works like in C: load the pointer and step by the pointee
+							auto ptrTy = std::static_pointer_cast<LILPointerType>(currentTy);
+							auto ptrArgTy = ptrTy->getArgument();
+							auto argIr = this->emit(arg.get());
+							if (!argIr) {
+								std::cerr << "CODEGEN OF ARGUMENT OF INDEX ACCESSOR FAILED!!!!!!!!!!!!!!!!\n";
+								return nullptr;
+							}
+							auto pointer = d->irBuilder.CreateLoad(this->llvmTypeFromLILType(currentTy.get()), d->currentAlloca);
+							d->currentAlloca = d->irBuilder.CreateGEP(this->llvmTypeFromLILType(ptrArgTy.get()), pointer, argIr);
+							if (isLastNode) {
+								llvm::Value * llvmValue = nullptr;
+								if (ptrArgTy->isA(TypeTypeMultiple))
+								{
+									auto multiTy = std::static_pointer_cast<LILMultipleType>(ptrArgTy);
+									llvmValue = this->emitForMultipleType(theValue.get(), multiTy);
+								} else {
+									llvmValue = this->emit(theValue.get());
+								}
+								this->_convertLlvmValueIfNeeded(&llvmValue, ty.get(), theValue->getType().get());
+
+								if (llvmValue) {
+									d->irBuilder.CreateStore(llvmValue, d->currentAlloca);
+								}
+								d->currentAlloca = allocaBackup;
+								return nullptr;
+							} else {
+								currentTy = ptrArgTy;
+							}
+							break;
+						}
 						default:
 							std::cerr << "!!!!!!!!UNIMPLEMENTED FAIL!!!!!!!!!!!!!!!!\n";
 							return nullptr;
@@ -1947,7 +2083,7 @@ llvm::Value * LILIREmitter::_emitVP(LILValuePath * value)
 						std::vector<llvm::Value *> argsvect;
 						argsvect.push_back(llvmSubject);
 						if (fun) {
-							llvmSubject = d->irBuilder.CreateCall(fun, argsvect);
+							llvmSubject = this->_emitCallWithAbi(fun->getFunctionType(), fun, fnTy.get(), argsvect, methodName);
 							if (isLastNode) {
 								return llvmSubject;
 							} else {
@@ -2027,6 +2163,24 @@ llvm::Value * LILIREmitter::_emitVP(LILValuePath * value)
 							}
 							break;
 						}
+						case TypeTypePointer:
+						{
+							auto ptrTy = std::static_pointer_cast<LILPointerType>(currentTy);
+							auto ptrArgTy = ptrTy->getArgument();
+							auto argIr = this->emit(arg.get());
+							if (!argIr) {
+								std::cerr << "CODEGEN OF ARGUMENT OF INDEX ACCESSOR FAILED!!!!!!!!!!!!!!!!\n";
+								return nullptr;
+							}
+							auto pointer = d->irBuilder.CreateLoad(this->llvmTypeFromLILType(currentTy.get()), llvmSubject);
+							llvmSubject = d->irBuilder.CreateGEP(this->llvmTypeFromLILType(ptrArgTy.get()), pointer, argIr);
+							if (isLastNode) {
+								return d->irBuilder.CreateLoad(this->llvmTypeFromLILType(ptrArgTy.get()), llvmSubject);
+							} else {
+								currentTy = ptrArgTy;
+							}
+							break;
+						}
 						case TypeTypeObject:
 						{
 							const auto & className = currentTy->getName();
@@ -2161,6 +2315,7 @@ void LILIREmitter::_connectRule(LILRule * value, llvm::Value * parentId, llvm::V
 		if (applyFn->getBasicBlockList().size() == 0) {
 			llvm::BasicBlock * bb = llvm::BasicBlock::Create(d->llvmContext, "entry", applyFn);
 			d->irBuilder.SetInsertPoint(bb);
+			this->_emitDOMMatchesFlag();
 		} else {
 			d->irBuilder.SetInsertPoint(&applyFn->getBasicBlockList().back());
 		}
@@ -2169,6 +2324,7 @@ void LILIREmitter::_connectRule(LILRule * value, llvm::Value * parentId, llvm::V
 		applyFn = this->_emitFnSignature(applyFnName, emptyFnTy.get());
 		llvm::BasicBlock * bb = llvm::BasicBlock::Create(d->llvmContext, "entry", applyFn);
 		d->irBuilder.SetInsertPoint(bb);
+		this->_emitDOMMatchesFlag();
 	}
 
 	const auto & selChNode = value->getSelectorChain();
@@ -2189,7 +2345,7 @@ void LILIREmitter::_connectRule(LILRule * value, llvm::Value * parentId, llvm::V
 			iterations = stol(numLit->getValue().data());
 		}
 		for (long int index = 0; index < iterations; index += 1) {
-			d->currentAlloca = d->irBuilder.CreateAlloca(this->llvmTypeFromLILType(ty.get()));
+			d->currentAlloca = this->createTemporaryAlloca(this->llvmTypeFromLILType(ty.get()));
 			auto cd = this->findClassWithName(ty->getName());
 			
 			auto initializeMethod = cd->getMethodNamed("initialize");
@@ -2209,9 +2365,17 @@ void LILIREmitter::_connectRule(LILRule * value, llvm::Value * parentId, llvm::V
 					//parentId
 					argsvect.push_back(parentId);
 					auto initializeReturn = d->irBuilder.CreateCall(initializeFn, argsvect);
+					if (d->domMatches) {
+						auto i1Ty = llvm::Type::getInt1Ty(d->llvmContext);
+						auto expectedId = llvm::ConstantInt::get(d->llvmContext, llvm::APInt(64, d->connectedElementCount, true));
+						auto idMatches = d->irBuilder.CreateICmpEQ(initializeReturn, expectedId);
+						auto matchedSoFar = d->irBuilder.CreateLoad(i1Ty, d->domMatches);
+						d->irBuilder.CreateStore(d->irBuilder.CreateAnd(matchedSoFar, idMatches), d->domMatches);
+					}
+					d->connectedElementCount += 1;
 					
 					auto llvmTy = this->llvmTypeFromLILType(ty.get());
-					d->currentAlloca = d->irBuilder.CreateAlloca(llvmTy, 0, "");
+					d->currentAlloca = this->createTemporaryAlloca(llvmTy);
 					//hack: using the array index to get to the id field of super
 					auto gep = this->_emitGEP(d->currentAlloca, llvmTy, true, 0, "id", true, true, 0);
 					d->irBuilder.CreateStore(initializeReturn, gep);
@@ -2244,9 +2408,46 @@ void LILIREmitter::_connectRule(LILRule * value, llvm::Value * parentId, llvm::V
 		return;
 	}
 
+	//elements created by the rules are known at compile time, so skip the runtime lookup,
+	//unless something else created elements in between and the ids of the DOM are off
+	std::vector<long int> staticIds;
+	if (d->domMatches && d->knownDOMMatch != 0 && this->_resolveStaticSelection(selCh.get(), parentIndex, staticIds)) {
+		if (d->knownDOMMatch == 1) {
+			this->_emitStaticSelection(value, ruleFn, staticIds, parentIndex);
+			return;
+		}
+		auto i1Ty = llvm::Type::getInt1Ty(d->llvmContext);
+		auto staticBB = llvm::BasicBlock::Create(d->llvmContext, "sel.static", applyFn);
+		auto runtimeBB = llvm::BasicBlock::Create(d->llvmContext, "sel.runtime");
+		auto afterBB = llvm::BasicBlock::Create(d->llvmContext, "sel.after");
+		d->irBuilder.CreateCondBr(d->irBuilder.CreateLoad(i1Ty, d->domMatches), staticBB, runtimeBB);
+
+		//the child rules append their blocks at the end of the function, so each branch
+		//is only added once the previous one is complete
+		d->irBuilder.SetInsertPoint(staticBB);
+		d->knownDOMMatch = 1;
+		this->_emitStaticSelection(value, ruleFn, staticIds, parentIndex);
+		d->irBuilder.CreateBr(afterBB);
+
+		applyFn->getBasicBlockList().push_back(runtimeBB);
+		d->irBuilder.SetInsertPoint(runtimeBB);
+		d->knownDOMMatch = 0;
+		this->_connectRuleAtRuntime(value, ruleFn, selCh.get(), parentId, parentIndex, thisObj, applyFn);
+		d->knownDOMMatch = -1;
+		applyFn->getBasicBlockList().push_back(afterBB);
+		d->irBuilder.CreateBr(afterBB);
+		d->irBuilder.SetInsertPoint(afterBB);
+		return;
+	}
+	this->_connectRuleAtRuntime(value, ruleFn, selCh.get(), parentId, parentIndex, thisObj, applyFn);
+}
+
+void LILIREmitter::_connectRuleAtRuntime(LILRule * value, llvm::Function * ruleFn, LILSelectorChain * selCh, llvm::Value * parentId, llvm::Value * parentIndex, llvm::Value * thisObj, llvm::Function * applyFn)
+{
+	auto ty = value->getType();
 	bool outIsId = false;
 	bool outNeedsAlloca = false;
-	auto selection = this->_emitSelCh(selCh.get(), outIsId, outNeedsAlloca, parentIndex, thisObj);
+	auto selection = this->_emitSelCh(selCh, outIsId, outNeedsAlloca, parentIndex, thisObj);
 	auto llvmTy = this->llvmTypeFromLILType(ty.get());
 	if (!selection) {
 		const auto & childRules = value->getChildRules();
@@ -2259,7 +2460,7 @@ void LILIREmitter::_connectRule(LILRule * value, llvm::Value * parentId, llvm::V
 	}
 	if (outIsId) {
 		if (outNeedsAlloca) {
-			d->currentAlloca = d->irBuilder.CreateAlloca(llvmTy, 0, "");
+			d->currentAlloca = this->createTemporaryAlloca(llvmTy);
 			//hack: using the array index to get to the id field of super
 			auto gep = this->_emitGEP(d->currentAlloca, llvmTy, true, 0, "id", true, true, 0);
 			d->irBuilder.CreateStore(selection, gep);
@@ -2297,59 +2498,36 @@ void LILIREmitter::_connectRule(LILRule * value, llvm::Value * parentId, llvm::V
 		auto afterBB = llvm::BasicBlock::Create(d->llvmContext, "sel_loop.after");
 		//var.i64 counter: 0;
 		auto i64Ty = llvm::Type::getInt64Ty(d->llvmContext);
-		auto counter = d->irBuilder.CreateAlloca(i64Ty, 0, "counter");
+		auto counter = this->createTemporaryAlloca(i64Ty, "counter");
 		auto zeroVal = llvm::ConstantInt::get(d->llvmContext, llvm::APInt(64, 0, true));
 		d->irBuilder.CreateStore(zeroVal, counter);
 		//counter<selection.size
 		std::vector<unsigned int> indices;
 		indices.push_back(1);
 		auto selectionSize = d->irBuilder.CreateExtractValue(selection, indices);
+		//the selection is a view: a pointer to the ids and their count
+		std::vector<unsigned int> idsIndices;
+		idsIndices.push_back(0);
+		auto selectionView = d->irBuilder.CreateExtractValue(selection, idsIndices);
+		//the rules of the selected elements may create elements, which rebuilds the hierarchy
+		//the view points into, so the loop walks a copy of the ids on the heap
+		auto i8PtrTy = llvm::Type::getInt8PtrTy(d->llvmContext);
+		auto mallocFn = d->llvmModule.getOrInsertFunction("malloc", llvm::FunctionType::get(i8PtrTy, {i64Ty}, false));
+		auto freeFn = d->llvmModule.getOrInsertFunction("free", llvm::FunctionType::get(llvm::Type::getVoidTy(d->llvmContext), {i8PtrTy}, false));
+		auto selectionBytes = d->irBuilder.CreateMul(selectionSize, llvm::ConstantInt::get(d->llvmContext, llvm::APInt(64, 8, true)));
+		auto selectionCopy = d->irBuilder.CreateCall(mallocFn, {selectionBytes}, "sel.ids.copy");
+		auto selectionIds = d->irBuilder.CreatePointerCast(selectionCopy, i64Ty->getPointerTo(), "sel.ids");
+		d->irBuilder.CreateMemCpy(selectionIds, llvm::MaybeAlign(8), selectionView, llvm::MaybeAlign(8), selectionBytes);
 		auto condition = d->irBuilder.CreateICmpSLT(zeroVal, selectionSize);
 
 		d->irBuilder.CreateCondBr(condition, loopBB, afterBB);
 		
 		d->irBuilder.SetInsertPoint(loopBB);
-		std::vector<llvm::Value *> idList;
-		idList.push_back(llvm::ConstantInt::get(d->llvmContext, llvm::APInt(LIL_GEP_INDEX_SIZE, 0, false)));
-		idList.push_back(llvm::ConstantInt::get(d->llvmContext, llvm::APInt(LIL_GEP_INDEX_SIZE, 0, false)));
-		idList.push_back(d->irBuilder.CreateLoad(i64Ty, counter));
-		idList.push_back(llvm::ConstantInt::get(d->llvmContext, llvm::APInt(LIL_GEP_INDEX_SIZE, 0, false)));
-		auto selClassTy = d->classTypes["sel"];
-		auto selAlloca = d->irBuilder.CreateAlloca(selClassTy);
-		d->irBuilder.CreateStore(selection, selAlloca);
-		auto currentIdGep = llvm::GetElementPtrInst::Create(selClassTy, selAlloca, idList, "currentId", d->irBuilder.GetInsertBlock());
-		auto currentId = d->irBuilder.CreateLoad(i64Ty, currentIdGep);
-		
-		bool needsCast = tyName != "container";
-		llvm::Type * containerTy;
-		if (needsCast) {
-			containerTy = d->classTypes.at("container");
-		} else {
-			containerTy = llvmTy;
-		}
-		d->currentAlloca = d->irBuilder.CreateAlloca(containerTy);
-		//hack: using the array index to get to the id field of super
-		auto gep = this->_emitGEP(d->currentAlloca, containerTy, true, 0, "id", true, true, 0);
-		d->irBuilder.CreateStore(currentId, gep);
-		std::vector<llvm::Value *> argsvect;
-		if (needsCast) {
-			d->currentAlloca = d->irBuilder.CreatePointerCast(d->currentAlloca, llvmTy->getPointerTo());
-		}
-		argsvect.push_back(d->currentAlloca);
-
+		this->pushLifetimeScope();
 		auto counterVal = d->irBuilder.CreateLoad(i64Ty, counter);
-		argsvect.push_back(counterVal);
-
-		d->irBuilder.CreateCall(ruleFn, argsvect);
-
-		const auto & childRules = value->getChildRules();
-		if (childRules.size() > 0) {
-			auto i64Ty = llvm::Type::getInt64Ty(d->llvmContext);
-			auto idValue = d->irBuilder.CreateLoad(i64Ty, gep);
-			for (auto child : childRules) {
-				this->_connectRule(child.get(), idValue, parentIndex, d->currentAlloca);
-			}
-		}
+		auto currentIdGep = d->irBuilder.CreateGEP(i64Ty, selectionIds, counterVal, "currentId");
+		auto currentId = d->irBuilder.CreateLoad(i64Ty, currentIdGep);
+		this->_emitRuleCallForId(value, ruleFn, currentId, counterVal, parentIndex);
 
 		//counter +: 1
 		auto oneVal = llvm::ConstantInt::get(d->llvmContext, llvm::APInt(64, 1, true));
@@ -2357,10 +2535,220 @@ void LILIREmitter::_connectRule(LILRule * value, llvm::Value * parentId, llvm::V
 		d->irBuilder.CreateStore(increased, counter);
 		
 		auto condition2 = d->irBuilder.CreateICmpSLT(increased, selectionSize);
+		this->popLifetimeScope();
 		applyFn->getBasicBlockList().push_back(afterBB);
 		d->irBuilder.CreateCondBr(condition2, loopBB, afterBB);
 		d->irBuilder.SetInsertPoint(afterBB);
+		d->irBuilder.CreateCall(freeFn, {selectionCopy});
+	}
+}
+
+void LILIREmitter::_emitRuleCallForId(LILRule * value, llvm::Function * ruleFn, llvm::Value * idValue, llvm::Value * indexValue, llvm::Value * parentIndex)
+{
+	auto ty = value->getType();
+	auto llvmTy = this->llvmTypeFromLILType(ty.get());
+	bool needsCast = ty->getName() != "container";
+	llvm::Type * containerTy;
+	if (needsCast) {
+		containerTy = d->classTypes.at("container");
+	} else {
+		containerTy = llvmTy;
+	}
+	d->currentAlloca = this->createTemporaryAlloca(containerTy);
+	//hack: using the array index to get to the id field of super
+	auto gep = this->_emitGEP(d->currentAlloca, containerTy, true, 0, "id", true, true, 0);
+	d->irBuilder.CreateStore(idValue, gep);
+	std::vector<llvm::Value *> argsvect;
+	if (needsCast) {
+		d->currentAlloca = d->irBuilder.CreatePointerCast(d->currentAlloca, llvmTy->getPointerTo());
+	}
+	argsvect.push_back(d->currentAlloca);
+	argsvect.push_back(indexValue);
+
+	d->irBuilder.CreateCall(ruleFn, argsvect);
+
+	const auto & childRules = value->getChildRules();
+	if (childRules.size() > 0) {
+		auto i64Ty = llvm::Type::getInt64Ty(d->llvmContext);
+		auto childParentId = d->irBuilder.CreateLoad(i64Ty, gep);
+		auto thisObj = d->currentAlloca;
+		for (auto child : childRules) {
+			this->_connectRule(child.get(), childParentId, parentIndex, thisObj);
+		}
+	}
+}
+
+void LILIREmitter::_emitStaticSelection(LILRule * value, llvm::Function * ruleFn, const std::vector<long int> & ids, llvm::Value * parentIndex)
+{
+	for (size_t i=0, j=ids.size(); i<j; ++i) {
+		auto idValue = llvm::ConstantInt::get(d->llvmContext, llvm::APInt(64, ids[i], true));
+		auto indexValue = llvm::ConstantInt::get(d->llvmContext, llvm::APInt(64, i, true));
+		this->_emitRuleCallForId(value, ruleFn, idValue, indexValue, parentIndex);
+	}
+}
+
+//called at the start of LIL__applyRules. Static selections are only emitted when the rules
+//can't create other elements than those of the DOM, and even then a class whose initialize
+//creates more than one element, or code that created elements before the rules are applied,
+//shifts the ids, which the check at each #new catches at runtime
+void LILIREmitter::_emitDOMMatchesFlag()
+{
+	if (!this->_isDOMStatic()) {
+		return;
+	}
+	auto i1Ty = llvm::Type::getInt1Ty(d->llvmContext);
+	d->domMatches = this->createTemporaryAlloca(i1Ty, "dom.matches");
+	d->irBuilder.CreateStore(llvm::ConstantInt::getTrue(d->llvmContext), d->domMatches);
+}
+
+bool LILIREmitter::_isDOMStatic()
+{
+	if (d->domIsStatic == -1) {
+		long int nextId = 0;
+		bool sawMenu = false;
+		bool isStatic = this->getDOM() && this->_domHasMenusLast(this->getDOM().get(), nextId, sawMenu);
+		if (isStatic) {
+			for (const auto & rule : this->getRootNode()->getRules()) {
+				if (!this->_ruleCreatesOnlyDOMElements(rule.get(), true)) {
+					isStatic = false;
+					break;
+				}
+			}
+		}
+		d->domIsStatic = isStatic ? 1 : 0;
 	}
+	return d->domIsStatic == 1;
+}
+
+//the DOM builder gives ids to the menus too, but they are not elements, so nothing
+//else may come after them. The ids are handed out depth first, so that is the order
+bool LILIREmitter::_domHasMenusLast(LILElement * elem, long int & nextId, bool & sawMenu) const
+{
+	if (elem->id != nextId) {
+		return false;
+	}
+	nextId += 1;
+	if (elem->ty) {
+		const auto & tyName = elem->ty->getName();
+		if (tyName == "mainMenu" || tyName == "menuItem" || tyName == "menu") {
+			sawMenu = true;
+		} else if (sawMenu) {
+			return false;
+		}
+	}
+	for (const auto & child : elem->getChildren()) {
+		if (!this->_domHasMenusLast(child.get(), nextId, sawMenu)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//the DOM builder only follows the #new rules nested in other #new rules, starting at the
+//children of the top level rules, and code in the rule bodies may create elements
+bool LILIREmitter::_ruleCreatesOnlyDOMElements(LILRule * rule, bool isTopLevel) const
+{
+	auto ty = rule->getType();
+	if (ty) {
+		const auto & tyName = ty->getName();
+		if (tyName == "mainMenu" || tyName == "menuItem" || tyName == "menu") {
+			return true;
+		}
+	}
+	const auto & instrNode = rule->getInstruction();
+	bool creates = instrNode && instrNode->getInstructionType() == InstructionTypeNew;
+	for (const auto & val : rule->getValues()) {
+		if (this->_runsCode(val.get())) {
+			return false;
+		}
+	}
+	for (const auto & child : rule->getChildRules()) {
+		const auto & childInstr = child->getInstruction();
+		bool childCreates = childInstr && childInstr->getInstructionType() == InstructionTypeNew;
+		if (childCreates && !creates && !isTopLevel) {
+			return false;
+		}
+		if (!this->_ruleCreatesOnlyDOMElements(child.get(), false)) {
+			return false;
+		}
+	}
+	return !creates || !isTopLevel;
+}
+
+bool LILIREmitter::_runsCode(LILNode * node) const
+{
+	switch (node->getNodeType()) {
+		case NodeTypeFunctionCall:
+			return true;
+		case NodeTypeFunctionDecl:
+			//only runs when it is called, e.g. on an action
+			return false;
+		default:
+			break;
+	}
+	for (const auto & child : node->getChildNodes()) {
+		if (this->_runsCode(child.get())) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool LILIREmitter::_resolveStaticSelection(LILSelectorChain * value, llvm::Value * parentIndex, std::vector<long int> & outIds)
+{
+	//this mirrors the runtime path in _emitSelCh, which uses LIL__selectByName(nameId, parentIndex)
+	if (value->getNodes().size() < 2 || !this->getDOM()) {
+		return false;
+	}
+	auto parentConst = llvm::dyn_cast<llvm::ConstantInt>(parentIndex);
+	if (!parentConst) {
+		return false;
+	}
+	for (const auto & schNode : value->getNodes()) {
+		if (schNode->getNodeType() != NodeTypeSimpleSelector) {
+			return false;
+		}
+		auto ss = std::static_pointer_cast<LILSimpleSelector>(schNode);
+		for (const auto & ssNode : ss->getNodes()) {
+			if (ssNode->getNodeType() != NodeTypeSelector) {
+				return false;
+			}
+			if (ssNode->getSelectorType() != SelectorTypeNameSelector) {
+				continue;
+			}
+			auto sel = std::static_pointer_cast<LILSelector>(ssNode);
+			auto parent = this->_findElementWithId(this->getDOM().get(), parentConst->getSExtValue());
+			if (!parent) {
+				return false;
+			}
+			const auto & name = sel->getName();
+			for (const auto & child : parent->getChildren()) {
+				//only the elements that have already been created at this point of LIL__applyRules
+				if (child->name == name && child->id < d->connectedElementCount) {
+					outIds.push_back(child->id);
+				}
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+LILElement * LILIREmitter::_findElementWithId(LILElement * elem, long int id) const
+{
+	if (elem->id == id) {
+		return elem;
+	}
+	for (const auto & child : elem->getChildren()) {
+		if (child->id > id) {
+			break;
+		}
+		auto ret = this->_findElementWithId(child.get(), id);
+		if (ret) {
+			return ret;
+		}
+	}
+	return nullptr;
 }
 
 llvm::Value* LILIREmitter::_getContainerNameFromSelectorChain(std::shared_ptr<LILSelectorChain> selCh)
@@ -2512,7 +2900,7 @@ llvm::Value * LILIREmitter::_emitSelCh(LILSelectorChain * value, bool & outIsId,
 						std::vector<llvm::Value *> selectArgs;
 						selectArgs.push_back(nameId);
 						selectArgs.push_back(parentIndex);
-						return d->irBuilder.CreateCall(selectFun, selectArgs, "selection");
+						return this->_emitCallWithAbi(selectFun->getFunctionType(), selectFun, selectFnTy.get(), selectArgs, "selection");
 					}
 						
 					default:
@@ -2555,6 +2943,26 @@ llvm::Value * LILIREmitter::_emitSel(LILSelector * value)
 					std::cerr << "CLASS " + subjTy->getName().data() +  " NOT FOUND FAIL!!!!!!!!!!!!!!\n";
 					return nullptr;
 				}
+				//the loop already holds the start of the elements, see _emitFor
+				if (forBlock->getIteratesData() && d->iterationData.count(forBlock.get())) {
+					auto dataPtr = d->iterationData[forBlock.get()];
+					auto dataInstr = llvm::dyn_cast<llvm::Instruction>(dataPtr);
+					auto dataMeth = cd->getMethodNamed("data");
+					//the body of a #parallel for is outlined and can't see it
+					if (
+						dataInstr && dataMeth
+						&& dataInstr->getFunction() == d->irBuilder.GetInsertBlock()->getParent()
+					) {
+						auto dataRetTy = std::static_pointer_cast<LILFunctionDecl>(dataMeth)->getFnType()->getReturnType();
+						auto elementTy = this->llvmTypeFromLILType(std::static_pointer_cast<LILPointerType>(dataRetTy)->getArgument().get());
+						auto vn = std::make_shared<LILVarName>();
+						vn->setName("@key");
+						vn->setParentNode(value->getParentNode());
+						auto keyVal = this->_emitVN(vn.get());
+						auto elementPtr = d->irBuilder.CreateInBoundsGEP(elementTy, dataPtr, keyVal, "for.element");
+						return d->irBuilder.CreateLoad(elementTy, elementPtr, "@value");
+					}
+				}
 				auto meth = cd->getMethodNamed("value");
 				if (meth) {
 					if (!meth->isA(NodeTypeFunctionDecl)) {
@@ -2572,7 +2980,7 @@ llvm::Value * LILIREmitter::_emitSel(LILSelector * value)
 						std::vector<llvm::Value *> argsvect;
 						argsvect.push_back(this->emitPointer(subjectNode.get()));
 						argsvect.push_back(keyVal);
-						return d->irBuilder.CreateCall(fun, argsvect);
+						return this->_emitCallWithAbi(fun->getFunctionType(), fun, fd->getFnType().get(), argsvect, fd->getName());
 					} else {
 						std::cerr << "COULD NOT CALL VALUE METHOD FAIL!!!!\n\n";
 						return nullptr;
@@ -2738,11 +3146,49 @@ llvm::Function * LILIREmitter::_emitFnSignature(std::string name, LILFunctionTyp
 		return existingFun;
 	} else {
 		llvm::Function * fun = llvm::Function::Create(ft, llvm::Function::ExternalLinkage, name, &d->llvmModule);
+		for (const auto & attr : this->_getAbiAttributes(fnTy)) {
+			fun->addParamAttr(attr.first, attr.second);
+		}
 		return fun;
 	}
 }
 
 llvm::FunctionType * LILIREmitter::_emitLlvmFnType(LILFunctionType * fnTy)
+{
+	std::vector<llvm::Type*> types;
+	llvm::Type * returnType = this->_llvmReturnTypeFromFnType(fnTy);
+	if (this->_isPassedIndirectly(returnType)) {
+		types.push_back(returnType->getPointerTo());
+		returnType = llvm::Type::getVoidTy(d->llvmContext);
+	} else if (auto coercedTy = this->_getAbiCoercedType(returnType)) {
+		returnType = coercedTy;
+	}
+	for (auto llvmTy : this->_llvmArgTypesFromFnType(fnTy)) {
+		if (this->_isPassedIndirectly(llvmTy)) {
+			types.push_back(llvmTy->getPointerTo());
+		} else if (auto coercedTy = this->_getAbiCoercedType(llvmTy)) {
+			types.push_back(coercedTy);
+		} else {
+			types.push_back(llvmTy);
+		}
+	}
+	return llvm::FunctionType::get(returnType, types, fnTy->getIsVariadic());
+}
+
+llvm::Type * LILIREmitter::_llvmReturnTypeFromFnType(LILFunctionType * fnTy)
+{
+	std::shared_ptr<LILType> retTy = fnTy->getReturnType();
+	llvm::Type * returnType = nullptr;
+	if (retTy) {
+		returnType = this->llvmTypeFromLILType(retTy.get());
+	}
+	if (!returnType) {
+		returnType = llvm::Type::getVoidTy(d->llvmContext);
+	}
+	return returnType;
+}
+
+std::vector<llvm::Type *> LILIREmitter::_llvmArgTypesFromFnType(LILFunctionType * fnTy)
 {
 	std::vector<llvm::Type*> types;
 	auto arguments = fnTy->getArguments();
@@ -2766,34 +3212,362 @@ llvm::FunctionType * LILIREmitter::_emitLlvmFnType(LILFunctionType * fnTy)
 			std::cerr << "!!!!!!!!!!EMIT FN SIGNATURE FAIL!!!!!!!!!!!!!!!!\n";
 		}
 	}
-	
-	std::shared_ptr<LILType> retTy = fnTy->getReturnType();
-	llvm::Type * returnType = nullptr;
-	if (retTy) {
-		returnType = this->llvmTypeFromLILType(retTy.get());
+	return types;
+}
+
+bool LILIREmitter::_isPassedIndirectly(llvm::Type * llvmTy) const
+{
+	if (!llvmTy || !(llvmTy->isStructTy() || llvmTy->isArrayTy()) || !llvmTy->isSized()) {
+		return false;
 	}
-	if (!returnType) {
-		returnType = llvm::Type::getVoidTy(d->llvmContext);
+	uint64_t size = d->llvmModule.getDataLayout().getTypeAllocSize(llvmTy).getFixedSize();
+	llvm::Triple triple(d->llvmModule.getTargetTriple());
+	if (triple.getArch() == llvm::Triple::x86_64 && triple.isOSWindows()) {
+		//the Microsoft x64 ABI only passes aggregates in a register when they fill it exactly
+		return size != 1 && size != 2 && size != 4 && size != 8;
 	}
-	return llvm::FunctionType::get(returnType, types, fnTy->getIsVariadic());
+	if (size <= LIL_ABI_INDIRECT_MIN_SIZE) {
+		return false;
+	}
+	//up to four floats or doubles of the same type go in the vector registers on AArch64
+	if (triple.isAArch64() && this->_getAbiCoercedType(llvmTy)) {
+		return false;
+	}
+	return true;
 }
 
-llvm::Function * LILIREmitter::_emitFn(LILFunctionDecl * value)
+bool LILIREmitter::_usesByValAttribute() const
 {
-	auto fnTy = std::static_pointer_cast<LILFunctionType>(value->getType());
-	auto arguments = fnTy->getArguments();
-	std::string fnName = value->getName().data();
-	llvm::Function * fun = this->_emitFnSignature(fnName, fnTy.get());
-	d->namedValues[fnName] = fun;
-	if (value->getIsExtern()) {
-		return fun;
-	}
+	//AAPCS64 and the Microsoft x64 ABI pass large aggregates as a plain pointer to a caller owned copy
+	llvm::Triple triple(d->llvmModule.getTargetTriple());
+	return !triple.isAArch64() && !(triple.getArch() == llvm::Triple::x86_64 && triple.isOSWindows());
+}
 
-	size_t argIndex = 0;
-	for (auto & llvmArg : fun->args()) {
-		auto arg = arguments[argIndex];
-		if(!arg){
-			std::cerr << "!!!!!!!!!!ARGUMENT WAS NULL FAIL!!!!!!!!!!!!!!!!\n";
+//the type that an aggregate passed in registers is reinterpreted as, so that it lands in the same
+//registers as in C, or null where llvm's own lowering of the struct is used
+llvm::Type * LILIREmitter::_getAbiCoercedType(llvm::Type * llvmTy) const
+{
+	if (!llvmTy || !(llvmTy->isStructTy() || llvmTy->isArrayTy()) || !llvmTy->isSized()) {
+		return nullptr;
+	}
+	const auto & layout = d->llvmModule.getDataLayout();
+	uint64_t size = layout.getTypeAllocSize(llvmTy).getFixedSize();
+	if (size == 0) {
+		return nullptr;
+	}
+	auto & context = d->llvmContext;
+	llvm::Triple triple(d->llvmModule.getTargetTriple());
+	std::vector<std::pair<uint64_t, llvm::Type *>> scalars;
+
+	if (triple.isAArch64()) {
+		//homogeneous float aggregates
+		if (size <= 32 && this->_flattenAbiAggregate(llvmTy, 0, scalars) && scalars.size() > 0 && scalars.size() <= 4) {
+			llvm::Type * baseTy = scalars.front().second;
+			bool isHFA = baseTy->isFloatingPointTy();
+			for (const auto & scalar : scalars) {
+				if (scalar.second != baseTy) {
+					isHFA = false;
+				}
+			}
+			if (isHFA) {
+				return llvm::ArrayType::get(baseTy, scalars.size());
+			}
+		}
+		if (size > LIL_ABI_INDIRECT_MIN_SIZE) {
+			return nullptr;
+		}
+		if (size <= 8) {
+			return llvm::Type::getInt64Ty(context);
+		}
+		if (layout.getABITypeAlign(llvmTy).value() == 16) {
+			return llvm::Type::getInt128Ty(context);
+		}
+		return llvm::ArrayType::get(llvm::Type::getInt64Ty(context), 2);
+	}
+
+	if (triple.getArch() == llvm::Triple::x86_64) {
+		if (triple.isOSWindows()) {
+			if (size == 1 || size == 2 || size == 4 || size == 8) {
+				return llvm::IntegerType::get(context, size * 8);
+			}
+			return nullptr;
+		}
+		//System V: each eightbyte goes in an SSE register when it holds only floats, otherwise in a general one
+		if (size > LIL_ABI_INDIRECT_MIN_SIZE || !this->_flattenAbiAggregate(llvmTy, 0, scalars)) {
+			return nullptr;
+		}
+		std::vector<llvm::Type *> eightbytes;
+		for (uint64_t start = 0; start < size; start += 8) {
+			uint64_t eightbyteSize = std::min<uint64_t>(8, size - start);
+			std::vector<llvm::Type *> floatTys;
+			bool isInteger = false;
+			for (const auto & scalar : scalars) {
+				if (scalar.first < start || scalar.first >= start + 8) {
+					continue;
+				}
+				if (scalar.second->isFloatingPointTy()) {
+					floatTys.push_back(scalar.second);
+				} else {
+					isInteger = true;
+				}
+			}
+			if (isInteger || floatTys.empty()) {
+				eightbytes.push_back(llvm::IntegerType::get(context, eightbyteSize * 8));
+				continue;
+			}
+			for (auto floatTy : floatTys) {
+				if (floatTy != floatTys.front()) {
+					return nullptr;
+				}
+			}
+			if (floatTys.size() == 1) {
+				eightbytes.push_back(floatTys.front());
+			} else {
+				eightbytes.push_back(llvm::FixedVectorType::get(floatTys.front(), floatTys.size()));
+			}
+		}
+		if (eightbytes.size() == 1) {
+			return eightbytes.front();
+		}
+		return llvm::StructType::get(context, eightbytes);
+	}
+	return nullptr;
+}
+
+//collects the scalar fields of an aggregate with their byte offsets, false when it has something
+//the register classification doesn't handle, like vectors or packed structs
+bool LILIREmitter::_flattenAbiAggregate(llvm::Type * llvmTy, uint64_t offset, std::vector<std::pair<uint64_t, llvm::Type *>> & scalars) const
+{
+	const auto & layout = d->llvmModule.getDataLayout();
+	if (llvmTy->isStructTy()) {
+		auto structTy = llvm::cast<llvm::StructType>(llvmTy);
+		if (structTy->isPacked()) {
+			return false;
+		}
+		auto structLayout = layout.getStructLayout(structTy);
+		for (unsigned i=0, j=structTy->getNumElements(); i<j; ++i) {
+			if (!this->_flattenAbiAggregate(structTy->getElementType(i), offset + structLayout->getElementOffset(i), scalars)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	if (llvmTy->isArrayTy()) {
+		auto elementTy = llvmTy->getArrayElementType();
+		uint64_t elementSize = layout.getTypeAllocSize(elementTy).getFixedSize();
+		for (uint64_t i=0, j=llvmTy->getArrayNumElements(); i<j; ++i) {
+			if (!this->_flattenAbiAggregate(elementTy, offset + (i * elementSize), scalars)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	if (llvmTy->isIntegerTy() || llvmTy->isPointerTy() || llvmTy->isHalfTy() || llvmTy->isFloatTy() || llvmTy->isDoubleTy()) {
+		scalars.push_back({ offset, llvmTy });
+		return true;
+	}
+	return false;
+}
+
+//reinterprets the bytes of the value as the other type, through memory like C compilers do
+llvm::Value * LILIREmitter::_emitAbiCoercion(llvm::Value * value, llvm::Type * toTy)
+{
+	const auto & layout = d->llvmModule.getDataLayout();
+	llvm::Function * fun = d->irBuilder.GetInsertBlock()->getParent();
+	llvm::Type * fromTy = value->getType();
+	llvm::AllocaInst * src = this->createEntryBlockAlloca(fun, "abi.src", fromTy);
+	llvm::AllocaInst * dst = this->createEntryBlockAlloca(fun, "abi.dst", toTy);
+	d->irBuilder.CreateStore(value, src);
+	uint64_t size = std::min(layout.getTypeStoreSize(fromTy).getFixedSize(), layout.getTypeStoreSize(toTy).getFixedSize());
+	d->irBuilder.CreateMemCpy(dst, dst->getAlign(), src, src->getAlign(), size);
+	return d->irBuilder.CreateLoad(toTy, dst);
+}
+
+std::vector<std::pair<unsigned, llvm::Attribute>> LILIREmitter::_getAbiAttributes(LILFunctionType * fnTy)
+{
+	std::vector<std::pair<unsigned, llvm::Attribute>> ret;
+	unsigned argIndex = 0;
+	llvm::Type * returnType = this->_llvmReturnTypeFromFnType(fnTy);
+	if (this->_isPassedIndirectly(returnType)) {
+		ret.push_back({ argIndex, llvm::Attribute::getWithStructRetType(d->llvmContext, returnType) });
+		ret.push_back({ argIndex, llvm::Attribute::get(d->llvmContext, llvm::Attribute::NoAlias) });
+		argIndex += 1;
+	}
+	bool usesByVal = this->_usesByValAttribute();
+	for (auto llvmTy : this->_llvmArgTypesFromFnType(fnTy)) {
+		if (usesByVal && this->_isPassedIndirectly(llvmTy)) {
+			ret.push_back({ argIndex, llvm::Attribute::getWithByValType(d->llvmContext, llvmTy) });
+		}
+		argIndex += 1;
+	}
+	return ret;
+}
+
+llvm::Value * LILIREmitter::_emitCallWithAbi(llvm::FunctionType * llvmFnTy, llvm::Value * fun, LILFunctionType * fnTy, const std::vector<llvm::Value *> & args, const LILString & name)
+{
+	llvm::Function * currentFun = d->irBuilder.GetInsertBlock()->getParent();
+	std::vector<llvm::Value *> callArgs;
+
+	llvm::Type * returnType = this->_llvmReturnTypeFromFnType(fnTy);
+	llvm::AllocaInst * sretAlloca = nullptr;
+	if (this->_isPassedIndirectly(returnType)) {
+		sretAlloca = this->createEntryBlockAlloca(currentFun, name.data()+"_sret", returnType);
+		callArgs.push_back(sretAlloca);
+	}
+	size_t declArgsSize = this->_llvmArgTypesFromFnType(fnTy).size();
+	bool usesByVal = this->_usesByValAttribute();
+	for (size_t i=0, j=args.size(); i<j; ++i) {
+		auto arg = args[i];
+		if (i < declArgsSize && this->_isPassedIndirectly(arg->getType())) {
+			//an aggregate that was just loaded is passed from where it lives
+			auto load = this->_getUnchangedLoad(arg);
+			if (load && usesByVal) {
+				//the byval attribute already gives the callee its own copy
+				callArgs.push_back(load->getPointerOperand());
+			} else {
+				//the callee gets its own copy, so it is free to modify it
+				llvm::AllocaInst * copy = this->createEntryBlockAlloca(currentFun, name.data()+"_arg", arg->getType());
+				if (load) {
+					const auto & layout = d->llvmModule.getDataLayout();
+					d->irBuilder.CreateMemCpy(copy, copy->getAlign(), load->getPointerOperand(), load->getAlign(), layout.getTypeStoreSize(arg->getType()).getFixedSize());
+				} else {
+					d->irBuilder.CreateStore(arg, copy);
+				}
+				callArgs.push_back(copy);
+			}
+			if (load && load->use_empty()) {
+				load->eraseFromParent();
+			}
+		} else if (i < declArgsSize && this->_getAbiCoercedType(arg->getType())) {
+			callArgs.push_back(this->_emitAbiCoercion(arg, this->_getAbiCoercedType(arg->getType())));
+		} else {
+			callArgs.push_back(arg);
+		}
+	}
+
+	llvm::CallInst * call;
+	if (sretAlloca || llvmFnTy->getReturnType()->isVoidTy()) {
+		call = d->irBuilder.CreateCall(llvmFnTy, fun, callArgs);
+	} else {
+		call = d->irBuilder.CreateCall(llvmFnTy, fun, callArgs, (name+"_return").data());
+	}
+	for (const auto & attr : this->_getAbiAttributes(fnTy)) {
+		call->addParamAttr(attr.first, attr.second);
+	}
+	if (sretAlloca) {
+		return d->irBuilder.CreateLoad(returnType, sretAlloca, (name+"_return").data());
+	}
+	if (call->getType() != returnType && !call->getType()->isVoidTy()) {
+		return this->_emitAbiCoercion(call, returnType);
+	}
+	return call;
+}
+
+//the load that produced the value, when nothing can have written to memory since, so that
+//its source still holds the same value and can be used in its place
+llvm::LoadInst * LILIREmitter::_getUnchangedLoad(llvm::Value * value) const
+{
+	auto load = llvm::dyn_cast<llvm::LoadInst>(value);
+	if (!load || load->isVolatile() || load->getParent() != d->irBuilder.GetInsertBlock() || d->irBuilder.GetInsertPoint() != d->irBuilder.GetInsertBlock()->end()) {
+		return nullptr;
+	}
+	for (auto instr = load->getNextNode(); instr; instr = instr->getNextNode()) {
+		if (instr->mayWriteToMemory()) {
+			return nullptr;
+		}
+	}
+	return load;
+}
+
+//stores the value into the variable. When the value is the result of a call that returns
+//through memory, the call writes it into the variable instead of into a temporary slot
+void LILIREmitter::_emitStoreToVariable(llvm::Value * value, llvm::Value * storage)
+{
+	auto load = llvm::dyn_cast<llvm::LoadInst>(value);
+	auto dst = llvm::dyn_cast<llvm::AllocaInst>(storage);
+	auto slot = load ? llvm::dyn_cast<llvm::AllocaInst>(load->getPointerOperand()) : nullptr;
+	auto call = load ? llvm::dyn_cast_or_null<llvm::CallInst>(load->getPrevNode()) : nullptr;
+	if (
+		dst && slot && call
+		&& load->use_empty()
+		&& this->_getUnchangedLoad(load)
+		&& call->hasStructRetAttr()
+		&& call->getArgOperand(0) == slot
+		&& slot->hasNUses(2)
+		&& slot->getAllocatedType() == dst->getAllocatedType()
+		&& this->_isUnescapedStorage(dst)
+	) {
+		call->setArgOperand(0, dst);
+		load->eraseFromParent();
+		slot->eraseFromParent();
+		return;
+	}
+	d->irBuilder.CreateStore(value, storage);
+}
+
+//whether the memory is only loaded from and stored to, so that no callee can see it
+bool LILIREmitter::_isUnescapedStorage(llvm::Value * storage) const
+{
+	for (const auto & use : storage->uses()) {
+		auto user = use.getUser();
+		if (llvm::isa<llvm::LoadInst>(user)) {
+			continue;
+		}
+		if (auto store = llvm::dyn_cast<llvm::StoreInst>(user)) {
+			if (store->getValueOperand() == storage) {
+				return false;
+			}
+			continue;
+		}
+		if (llvm::isa<llvm::GetElementPtrInst>(user) || llvm::isa<llvm::BitCastInst>(user)) {
+			if (!this->_isUnescapedStorage(user)) {
+				return false;
+			}
+			continue;
+		}
+		auto instr = llvm::dyn_cast<llvm::Instruction>(user);
+		if (instr && (llvm::isa<llvm::MemIntrinsic>(instr) || instr->isLifetimeStartOrEnd())) {
+			continue;
+		}
+		//a return slot that a call wrote into, or an argument the callee got a copy of
+		auto call = llvm::dyn_cast<llvm::CallInst>(user);
+		if (call && call->isArgOperand(&use)) {
+			unsigned argNo = call->getArgOperandNo(&use);
+			if ((argNo == 0 && call->hasStructRetAttr()) || call->isByValArgument(argNo)) {
+				continue;
+			}
+		}
+		return false;
+	}
+	return true;
+}
+
+llvm::Function * LILIREmitter::_emitFn(LILFunctionDecl * value)
+{
+	auto fnTy = std::static_pointer_cast<LILFunctionType>(value->getType());
+	auto arguments = fnTy->getArguments();
+	std::string fnName = value->getName().data();
+	llvm::Function * fun = this->_emitFnSignature(fnName, fnTy.get());
+	d->namedValues[fnName] = fun;
+	if (value->getIsExtern()) {
+		return fun;
+	}
+
+	//when returning through memory the first parameter is the caller's return slot
+	unsigned firstArg = fun->hasStructRetAttr() ? 1 : 0;
+	if (firstArg > 0) {
+		fun->getArg(0)->setName("@return");
+	}
+	std::vector<llvm::Type *> argTypes = this->_llvmArgTypesFromFnType(fnTy.get());
+
+	size_t argIndex = 0;
+	for (auto & llvmArg : fun->args()) {
+		if (llvmArg.getArgNo() < firstArg) {
+			continue;
+		}
+		auto arg = arguments[argIndex];
+		if(!arg){
+			std::cerr << "!!!!!!!!!!ARGUMENT WAS NULL FAIL!!!!!!!!!!!!!!!!\n";
 			return nullptr;
 		}
 
@@ -2812,15 +3586,30 @@ llvm::Function * LILIREmitter::_emitFn(LILFunctionDecl * value)
 	std::map<std::string, llvm::Value *> scope;
 	d->hiddenLocals.push_back(scope);
 
-	for (unsigned int i = 0; i<fun->arg_size(); i+=1) {
+	for (unsigned int i = firstArg; i<fun->arg_size(); i+=1) {
 		auto arg = fun->getArg(i);
 		auto name = std::string(arg->getName());
 		if (name == "@self") {
 			d->namedValues[name] = arg;
 			continue;
 		}
-		llvm::AllocaInst * alloca = this->createEntryBlockAlloca(fun, name, arg->getType());
-		d->irBuilder.CreateStore(arg, alloca);
+		size_t typeIndex = i - firstArg;
+		if (typeIndex < argTypes.size() && this->_isPassedIndirectly(argTypes[typeIndex])) {
+			//the argument already lives in memory, use it in place
+			if (d->namedValues.count(name)) {
+				d->hiddenLocals.back()[name] = d->namedValues[name];
+			}
+			d->namedValues[name] = arg;
+			continue;
+		}
+		llvm::Type * argTy = typeIndex < argTypes.size() ? argTypes[typeIndex] : arg->getType();
+		llvm::Value * argValue = arg;
+		if (argTy != arg->getType()) {
+			//small aggregates arrive in the registers the C ABI assigns them
+			argValue = this->_emitAbiCoercion(arg, argTy);
+		}
+		llvm::AllocaInst * alloca = this->createEntryBlockAlloca(fun, name, argTy);
+		d->irBuilder.CreateStore(argValue, alloca);
 		if (d->namedValues.count(name)) {
 			d->hiddenLocals.back()[name] = d->namedValues[name];
 		}
@@ -2848,10 +3637,18 @@ llvm::Function * LILIREmitter::_emitFnBody(llvm::Function * fun, LILFunctionDecl
 	auto body = value->getBody();
 
 	auto ty = value->getReturnType();
-	if (ty && ty->getName() != "null") {
-		d->returnAlloca = d->irBuilder.CreateAlloca(fun->getReturnType(), 0, "return");
+	bool usesSret = fun->hasStructRetAttr();
+	//the return value as LIL sees it, which can differ from the type the function returns in the registers
+	llvm::Type * returnType = this->_llvmReturnTypeFromFnType(value->getFnType().get());
+	if (usesSret) {
+		d->returnAlloca = fun->getArg(0);
+	} else if (ty && ty->getName() != "null") {
+		d->returnAlloca = this->createEntryBlockAlloca(fun, "return", returnType);
 	}
 	d->finallyBB = llvm::BasicBlock::Create(d->llvmContext, "finally");
+	//lifetime scopes never reach across functions
+	std::vector<std::vector<llvm::AllocaInst *>> lifetimeScopesBackup;
+	std::swap(lifetimeScopesBackup, d->lifetimeScopes);
 
 	this->_emitEvaluables(body);
 
@@ -2882,8 +3679,11 @@ llvm::Function * LILIREmitter::_emitFnBody(llvm::Function * fun, LILFunctionDecl
 		}
 	}
 
-	if (d->needsReturnValue) {
-		llvm::Value * loadInstr = d->irBuilder.CreateLoad(fun->getReturnType(), d->returnAlloca);
+	if (d->needsReturnValue && !usesSret) {
+		llvm::Value * loadInstr = d->irBuilder.CreateLoad(returnType, d->returnAlloca);
+		if (returnType != fun->getReturnType()) {
+			loadInstr = this->_emitAbiCoercion(loadInstr, fun->getReturnType());
+		}
 		d->irBuilder.CreateRet(loadInstr);
 	} else {
 		d->irBuilder.CreateRetVoid();
@@ -2892,14 +3692,38 @@ llvm::Function * LILIREmitter::_emitFnBody(llvm::Function * fun, LILFunctionDecl
 	d->returnAlloca = nullptr;
 	d->needsReturnValue = false;
 	d->finallyBB = nullptr;
+	std::swap(lifetimeScopesBackup, d->lifetimeScopes);
 
 	llvm::verifyFunction(*fun);
+	this->_checkAllocasInEntryBlock(fun, value);
 #ifdef LILIREMITTEROPTIMIZE
 	d->functionPassManager->run(*fun);
 #endif
 	return fun;
 }
 
+//an alloca anywhere else grows the stack every time its block runs, e.g. once per loop iteration
+void LILIREmitter::_checkAllocasInEntryBlock(llvm::Function * fun, LILNode * value)
+{
+	for (auto & block : *fun) {
+		if (&block == &fun->getEntryBlock()) {
+			continue;
+		}
+		for (auto & instr : block) {
+			if (llvm::isa<llvm::AllocaInst>(instr)) {
+				LILErrorMessage ei;
+				ei.message = "Internal error: the function "+LILString(fun->getName().str())+" allocates stack memory in its block "+LILString(block.getName().str())+" instead of the entry block";
+				LILNode::SourceLocation sl = value->getSourceLocation();
+				ei.file = sl.file;
+				ei.line = sl.line;
+				ei.column = sl.column;
+				this->errors.push_back(ei);
+				return;
+			}
+		}
+	}
+}
+
 void LILIREmitter::_emitDestructors(llvm::Value * ir, std::shared_ptr<LILClassDecl> cd, const LILString & name)
 {
 	size_t fieldIndex = 0;
@@ -2991,63 +3815,7 @@ llvm::Value * LILIREmitter::_emitFCMultipleValues(std::vector<std::shared_ptr<LI
 	if (needsRuntimeSelect) {
 		auto fcTy = fcTypes[i];
 		if (fcTy->isA(TypeTypeMultiple)) {
-			auto multiTy = std::static_pointer_cast<LILMultipleType>(fcTy);
-			auto argument = arguments[i];
-			std::string namestr;
-			if (argument->isA(NodeTypeVarName)) {
-				namestr = std::static_pointer_cast<LILVarName>(argument)->getName().data();
-			} else {
-				namestr = value->getName().data();
-			}
-			
-			auto llvmIr = this->emitPointer(argument.get());
-			
-			std::vector<llvm::Value *> gepIndices1;
-			gepIndices1.push_back(llvm::ConstantInt::get(d->llvmContext, llvm::APInt(LIL_GEP_INDEX_SIZE, 0, false)));
-			gepIndices1.push_back(llvm::ConstantInt::get(d->llvmContext, llvm::APInt(LIL_GEP_INDEX_SIZE, 1, false)));
-			auto argTy = this->llvmTypeFromLILType(argument->getType().get());
-			auto gep = d->irBuilder.CreateGEP(argTy, llvmIr, gepIndices1);
-			
-			auto argVal = d->irBuilder.CreateLoad(argTy, gep, namestr + "_lil_type_index");
-			
-			llvm::BasicBlock * defaultBB = llvm::BasicBlock::Create(d->llvmContext, namestr+ ".null");
-			llvm::SwitchInst * switchInstr = d->irBuilder.CreateSwitch(argVal, defaultBB);
-			llvm::BasicBlock * mergeBB = llvm::BasicBlock::Create(d->llvmContext, namestr + ".merge");
-
-			fun->getBasicBlockList().push_back(defaultBB);
-			d->irBuilder.SetInsertPoint(defaultBB);
-			
-			auto mfcTys = multiTy->getTypes();
-			if (multiTy->getIsNullable()){
-				mfcTys.push_back(LILType::make("null"));
-			}
-			size_t j = 1;
-			for (auto mfcTy : mfcTys) {
-				llvm::BasicBlock * bb;
-				if (mfcTy->getName() == "null") {
-					bb = defaultBB;
-				} else {
-					bb = llvm::BasicBlock::Create(d->llvmContext, namestr+"."+mfcTy->getName().data(), fun);
-					switchInstr->addCase(llvm::ConstantInt::get(d->llvmContext, llvm::APInt(8, j, false)), bb);
-				}
-				
-				std::vector<std::shared_ptr<LILType>> types;
-				for (size_t k=0; k<fcTypes.size(); ++k) {
-					if (k == i) {
-						types.push_back(mfcTy);
-					} else {
-						types.push_back(fcTy);
-					}
-				}
-				auto fd = this->chooseFnByType(funcDecls, types);
-				d->irBuilder.SetInsertPoint(bb);
-				this->_emitFunctionCallMT(value, fd->getName(), types, fd->getFnType().get(), instance);
-				d->irBuilder.CreateBr(mergeBB);
-				j += 1;
-			}
-			
-			fun->getBasicBlockList().push_back(mergeBB);
-			d->irBuilder.SetInsertPoint(mergeBB);
+			return this->_emitFCMultipleValuesSwitch(funcDecls, value, instance, fcTypes, i);
 		}
 		else if (fcTy->getIsNullable())
 		{
@@ -3085,7 +3853,7 @@ llvm::Value * LILIREmitter::_emitFCMultipleValues(std::vector<std::shared_ptr<LI
 				if (k == i) {
 					types.push_back(currentTy);
 				} else {
-					types.push_back(fcTy);
+					types.push_back(fcTypes[k]);
 				}
 			}
 			auto fd = this->chooseFnByType(funcDecls, types);
@@ -3103,7 +3871,7 @@ llvm::Value * LILIREmitter::_emitFCMultipleValues(std::vector<std::shared_ptr<LI
 				if (k == i) {
 					types2.push_back(nullTy);
 				} else {
-					types2.push_back(fcTy);
+					types2.push_back(fcTypes[k]);
 				}
 			}
 			auto fd2 = this->chooseFnByType(funcDecls, types2);
@@ -3124,6 +3892,121 @@ llvm::Value * LILIREmitter::_emitFCMultipleValues(std::vector<std::shared_ptr<LI
 	return nullptr;
 }
 
+llvm::Value * LILIREmitter::_emitFCMultipleValuesSwitch(const std::vector<std::shared_ptr<LILFunctionDecl>> & funcDecls, LILFunctionCall * value, llvm::Value * instance, const std::vector<std::shared_ptr<LILType>> & fcTypes, size_t i)
+{
+	auto arguments = value->getArguments();
+	llvm::Function * fun = d->irBuilder.GetInsertBlock()->getParent();
+	auto multiTy = std::static_pointer_cast<LILMultipleType>(fcTypes[i]);
+	//when calling a method, the first type is the one of the instance
+	size_t argIndex = instance == nullptr ? i : i - 1;
+	if (argIndex >= arguments.size()) {
+		std::cerr << "MULTIPLE TYPE ARGUMENT NOT FOUND FAIL!!!!\n\n";
+		return nullptr;
+	}
+	auto argument = arguments[argIndex];
+	if (argument->isA(NodeTypeAssignment)) {
+		argument = std::static_pointer_cast<LILAssignment>(argument)->getValue();
+	}
+	std::string namestr;
+	if (argument->isA(NodeTypeVarName)) {
+		namestr = std::static_pointer_cast<LILVarName>(argument)->getName().data();
+	} else {
+		namestr = value->getName().data();
+	}
+	
+	auto llvmIr = this->emitPointer(argument.get());
+	if (!llvmIr) {
+		std::cerr << "COULD NOT EMIT MULTIPLE TYPE ARGUMENT FAIL!!!!\n\n";
+		return nullptr;
+	}
+	
+	std::vector<llvm::Value *> gepIndices1;
+	gepIndices1.push_back(llvm::ConstantInt::get(d->llvmContext, llvm::APInt(LIL_GEP_INDEX_SIZE, 0, false)));
+	gepIndices1.push_back(llvm::ConstantInt::get(d->llvmContext, llvm::APInt(LIL_GEP_INDEX_SIZE, 1, false)));
+	auto argTy = this->llvmTypeFromLILType(argument->getType().get());
+	auto gep = d->irBuilder.CreateGEP(argTy, llvmIr, gepIndices1);
+	
+	auto argVal = d->irBuilder.CreateLoad(llvm::Type::getInt8Ty(d->llvmContext), gep, namestr + "_lil_type_index");
+	
+	llvm::BasicBlock * defaultBB = llvm::BasicBlock::Create(d->llvmContext, namestr+ ".null");
+	llvm::SwitchInst * switchInstr = d->irBuilder.CreateSwitch(argVal, defaultBB);
+	llvm::BasicBlock * mergeBB = llvm::BasicBlock::Create(d->llvmContext, namestr + ".merge");
+
+	fun->getBasicBlockList().push_back(defaultBB);
+	d->irBuilder.SetInsertPoint(defaultBB);
+	
+	auto mfcTys = multiTy->getTypes();
+	if (multiTy->getIsNullable()){
+		mfcTys.push_back(LILType::make("null"));
+	}
+	//the return value of the call in each case, with the block it comes from
+	std::vector<std::pair<llvm::Value *, llvm::BasicBlock *>> results;
+	size_t j = 1;
+	for (auto mfcTy : mfcTys) {
+		llvm::BasicBlock * bb;
+		if (mfcTy->getName() == "null") {
+			bb = defaultBB;
+		} else {
+			bb = llvm::BasicBlock::Create(d->llvmContext, namestr+"."+mfcTy->getName().data(), fun);
+			switchInstr->addCase(llvm::ConstantInt::get(d->llvmContext, llvm::APInt(8, j, false)), bb);
+		}
+		
+		std::vector<std::shared_ptr<LILType>> types = fcTypes;
+		types[i] = mfcTy;
+		d->irBuilder.SetInsertPoint(bb);
+
+		//the specializations cover all combinations, so later arguments get their own switch
+		size_t next = i + 1;
+		while (next < types.size() && !types[next]->isA(TypeTypeMultiple)) {
+			next += 1;
+		}
+		llvm::Value * result = nullptr;
+		if (next < types.size()) {
+			result = this->_emitFCMultipleValuesSwitch(funcDecls, value, instance, types, next);
+		} else {
+			auto fd = this->chooseFnByType(funcDecls, types);
+			if (fd) {
+				result = this->_emitFunctionCallMT(value, fd->getName(), types, fd->getFnType().get(), instance);
+			} else {
+				std::cerr << "COULD NOT CHOOSE FN BY TYPE FAIL\n\n";
+			}
+		}
+		results.push_back(std::make_pair(result, d->irBuilder.GetInsertBlock()));
+		d->irBuilder.CreateBr(mergeBB);
+		j += 1;
+	}
+	if (!multiTy->getIsNullable()) {
+		//the type index is always set, so nothing to call here
+		d->irBuilder.SetInsertPoint(defaultBB);
+		d->irBuilder.CreateBr(mergeBB);
+		results.push_back(std::make_pair(nullptr, defaultBB));
+	}
+	
+	fun->getBasicBlockList().push_back(mergeBB);
+	d->irBuilder.SetInsertPoint(mergeBB);
+
+	//all specializations return the same type, merge what they returned
+	llvm::Type * resultTy = nullptr;
+	for (const auto & result : results) {
+		if (result.first && !result.first->getType()->isVoidTy()) {
+			resultTy = result.first->getType();
+			break;
+		}
+	}
+	if (!resultTy) {
+		return nullptr;
+	}
+	llvm::PHINode * phi = d->irBuilder.CreatePHI(resultTy, results.size(), namestr + ".result");
+	for (const auto & result : results) {
+		if (result.first && result.first->getType() == resultTy) {
+			phi->addIncoming(result.first, result.second);
+		} else {
+			phi->addIncoming(llvm::UndefValue::get(resultTy), result.second);
+		}
+	}
+	return phi;
+}
+
 llvm::Value * LILIREmitter::_emitFC(LILFunctionCall * value)
 {
 	switch (value->getFunctionCallType()) {
@@ -3259,6 +4142,14 @@ llvm::Value * LILIREmitter::_emitFC(LILFunctionCall * value)
 			auto numTy = LILType::make("i64");
 			return d->irBuilder.CreatePointerCast(gep, this->llvmTypeFromLILType(numTy.get()));
 		}
+		case FunctionCallTypeSIMD:
+		{
+			return this->_emitSIMDCall(value);
+		}
+		case FunctionCallTypeAtomic:
+		{
+			return this->_emitAtomicCall(value);
+		}
 		case FunctionCallTypeSet:
 		{
 			auto args = value->getArguments();
@@ -3312,7 +4203,7 @@ llvm::Value * LILIREmitter::_emitFC(LILFunctionCall * value)
 						auto ruleFn = d->llvmModule.getFunction(rule->getFnName().data());
 						assert(ruleFn && "Rule function not found.");
 						auto llvmTy = this->llvmTypeFromLILType(rule->getType().get());
-						d->currentAlloca = d->irBuilder.CreateAlloca(llvmTy, 0, "");
+						d->currentAlloca = this->createTemporaryAlloca(llvmTy);
 						//hack: using the array index to get to the id field of super
 						auto gep = this->_emitGEP(d->currentAlloca, llvmTy, true, 0, "id", true, true, 0);
 						d->irBuilder.CreateStore(llvmIr, gep);
@@ -3571,12 +4462,7 @@ llvm::Value * LILIREmitter::_emitFunctionCall(LILFunctionCall * value, LILString
 			}
 		}
 
-		if(fun->getReturnType()->getTypeID() != llvm::Type::VoidTyID){
-			LILString callName = name+"_return";
-			return d->irBuilder.CreateCall(fun, argsvect, callName.data());
-		} else {
-			return d->irBuilder.CreateCall(fun, argsvect);
-		}
+		return this->_emitCallWithAbi(fun->getFunctionType(), fun, fnTy, argsvect, name);
 	}
 	return nullptr;
 }
@@ -3599,7 +4485,7 @@ llvm::Value * LILIREmitter::_emitFCArg(LILNode * value, LILType * ty)
 		} else {
 			allocaTy = this->llvmTypeFromLILType(ty);
 		}
-		d->currentAlloca = d->irBuilder.CreateAlloca(allocaTy);
+		d->currentAlloca = this->createTemporaryAlloca(allocaTy);
 	}
 
 	if (
@@ -3642,6 +4528,7 @@ llvm::Value * LILIREmitter::_emitFCArg(LILNode * value, LILType * ty)
 
 llvm::Value * LILIREmitter::_emitFunctionCallMT(LILFunctionCall *value, LILString name, std::vector<std::shared_ptr<LILType> > types, LILFunctionType * fnTy, llvm::Value * instance)
 {
+	bool isMethod = instance != nullptr;
 	llvm::Function* fun = d->llvmModule.getFunction(name.data());
 	auto fcArgs = value->getArguments();
 	if (!fun) {
@@ -3650,18 +4537,25 @@ llvm::Value * LILIREmitter::_emitFunctionCallMT(LILFunctionCall *value, LILStrin
 	if (fun) {
 		std::vector<llvm::Value *> argsvect;
 		
-		if (instance != nullptr){
-			argsvect.push_back(instance);
-		}
-		
 		auto declArgs = fnTy->getArguments();
 		auto fcArgsSize = fcArgs.size();
 		auto declArgsSize = declArgs.size();
+		
+		if (isMethod){
+			argsvect.push_back(instance);
+			declArgsSize -= 1;
+		}
+		
 		size_t j = fcArgsSize > declArgsSize ? fcArgsSize : declArgsSize;
 		for (size_t i = 0; i<j; ++i) {
+			//the types start with the one of the instance when calling a method
+			size_t declIndex = i;
+			if (isMethod) {
+				declIndex += 1;
+			}
 			std::shared_ptr<LILNode> fcArg;
 			if (fcArgsSize <= i) {
-				auto vdNode = declArgs[i];;
+				auto vdNode = declArgs[declIndex];
 				if (!vdNode->isA(NodeTypeVarDecl)) {
 					std::cerr << "DECL ARG IS NOT VAR DECL FAIL!!!!!!!!\n\n";
 					return nullptr;
@@ -3674,25 +4568,30 @@ llvm::Value * LILIREmitter::_emitFunctionCallMT(LILFunctionCall *value, LILStrin
 			
 			llvm::Value * fcArgIr;
 			std::shared_ptr<LILNode> fcValue;
+			if (fcArg->isA(NodeTypeAssignment)) {
+				fcValue = std::static_pointer_cast<LILAssignment>(fcArg)->getValue();
+			} else {
+				fcValue = fcArg;
+			}
+			auto fcValueTy = fcValue->getType();
+			bool isMultiple = fcValueTy && fcValueTy->isA(TypeTypeMultiple);
+			const auto & ty = types[declIndex];
 			
 			if (declArgsSize <= i)
 			{
-				fcArgIr = this->emitUnwrappedFromMT(fcArg.get(), types[i].get());
+				if (isMultiple) {
+					fcArgIr = this->emitUnwrappedFromMT(fcValue.get(), ty.get());
+				} else {
+					fcArgIr = this->_emitFCArg(fcValue.get(), ty.get());
+				}
 			}
 			else
 			{
-				auto declArg = declArgs[i];
+				auto declArg = declArgs[declIndex];
 				auto declArgTy = declArg->getType();
 				if (declArgTy->getName() == "null") {
 					continue;
 				}
-				
-				if (fcArg->isA(NodeTypeAssignment)) {
-					auto asgmt = std::static_pointer_cast<LILAssignment>(fcArg);
-					fcValue = asgmt->getValue();
-				} else {
-					fcValue = fcArg;
-				}
 				if (
 					declArgTy
 					&& declArgTy->getIsNullable()
@@ -3702,19 +4601,22 @@ llvm::Value * LILIREmitter::_emitFunctionCallMT(LILFunctionCall *value, LILStrin
 					if (
 						declArgTy
 						&& declArgTy->isA(TypeTypePointer)
-						&& !types[i]->isA(TypeTypePointer)
+						&& !ty->isA(TypeTypePointer)
 						) {
 						//fcArgIr = this->emitPointer(fcValue.get());
 						std::cerr << "!!!!!!!!!!UNIMPLEMENTED FAIL!!!!!!!!!!!!!!!!\n";
 						return nullptr;
+					} else if (isMultiple) {
+						fcArgIr = this->emitUnwrappedFromMT(fcValue.get(), ty.get());
 					} else {
-						fcArgIr = this->emitUnwrappedFromMT(fcArg.get(), types[i].get());
+						//only the arguments of multiple types are switched on
+						fcArgIr = this->_emitFCArg(fcValue.get(), declArgTy.get());
 					}
 				}
 				if (
 					declArgTy
 					&& !declArgTy->isA(TypeTypePointer)
-					&& types[i]->isA(TypeTypePointer)
+					&& ty->isA(TypeTypePointer)
 					) {
 					std::cerr << "!!!!!!!!!!UNIMPLEMENTED FAIL!!!!!!!!!!!!!!!!\n";
 					return nullptr;
@@ -3730,12 +4632,7 @@ llvm::Value * LILIREmitter::_emitFunctionCallMT(LILFunctionCall *value, LILStrin
 			}
 		}
 		
-		if(fun->getReturnType()->getTypeID() != llvm::Type::VoidTyID){
-			LILString callName = name+"_return";
-			return d->irBuilder.CreateCall(fun, argsvect, callName.data());
-		} else {
-			return d->irBuilder.CreateCall(fun, argsvect);
-		}
+		return this->_emitCallWithAbi(fun->getFunctionType(), fun, fnTy, argsvect, name);
 	}
 	return nullptr;
 }
@@ -3788,32 +4685,341 @@ llvm::Value * LILIREmitter::_emitFunctionCallPointer(llvm::Value * fun, LILFunct
 		{
 			fcArgIr = this->_emitFCArg(fcValue.get(), fcArg->getType().get());
 		}
-		else
-		{
-			auto declArg = declArgs[declIndex];
-			std::shared_ptr<LILType> declArgTy;
-			if (declArg->isA(NodeTypeType)) {
-				declArgTy = std::static_pointer_cast<LILType>(declArg);
-			} else {
-				declArgTy = declArg->getType();
-			}
-			fcArgIr = this->_emitFCArg(fcValue.get(), declArgTy.get());
+		else
+		{
+			auto declArg = declArgs[declIndex];
+			std::shared_ptr<LILType> declArgTy;
+			if (declArg->isA(NodeTypeType)) {
+				declArgTy = std::static_pointer_cast<LILType>(declArg);
+			} else {
+				declArgTy = declArg->getType();
+			}
+			fcArgIr = this->_emitFCArg(fcValue.get(), declArgTy.get());
+		}
+		
+		if (!fcArgIr) {
+			std::cerr << "!!!!!!!!!!ARG CODEGEN FAIL!!!!!!!!!!!!!!!\n";
+			return nullptr;
+		} else {
+			argsvect.push_back(fcArgIr);
+		}
+	}
+	
+	auto llvmTy = this->llvmTypeFromLILType(fnTy);
+	if (llvmTy->getTypeID() != llvm::Type::FunctionTyID) {
+		std::cerr << "TYPE OF CALL WAS NOT FUNCTION TYPE FAIL!!!!!!!!!!!!!!!\n";
+		return nullptr;
+	}
+	return this->_emitCallWithAbi(static_cast<llvm::FunctionType *>(llvmTy), fun, fnTy, argsvect, "");
+}
+
+llvm::Value * LILIREmitter::_emitSIMDCall(LILFunctionCall * value)
+{
+	const auto & name = value->getName();
+	const auto & args = value->getArguments();
+	if (args.size() == 0) {
+		std::cerr << "SIMD CALL WITHOUT ARGUMENTS FAIL!!!!!!!!!!!!!!!\n";
+		return nullptr;
+	}
+
+	if (name == "simdSplat" || name == "simdLoad") {
+		const auto & firstArg = args.front();
+		if (!firstArg->isA(NodeTypeTypeDecl) || args.size() != 2) {
+			std::cerr << "SIMD SPLAT OR LOAD NEEDS A TYPE AND A VALUE FAIL!!!!!!!!!!!!!!!\n";
+			return nullptr;
+		}
+		auto td = std::static_pointer_cast<LILTypeDecl>(firstArg);
+		auto llvmTy = this->llvmTypeFromLILType(td->getSrcType().get());
+		if (!llvm::isa<llvm::FixedVectorType>(llvmTy)) {
+			std::cerr << "TYPE OF SIMD SPLAT OR LOAD IS NOT A VECTOR FAIL!!!!!!!!!!!!!!!\n";
+			return nullptr;
+		}
+		auto vectorTy = llvm::cast<llvm::FixedVectorType>(llvmTy);
+		if (name == "simdSplat") {
+			auto scalar = this->_emitSIMDScalar(this->emit(args[1].get()), vectorTy->getElementType());
+			return d->irBuilder.CreateVectorSplat(vectorTy->getNumElements(), scalar);
+		}
+		//the data only needs to be aligned like its elements
+		auto address = this->_emitSIMDAddress(args[1].get(), vectorTy);
+		auto align = d->llvmModule.getDataLayout().getABITypeAlign(vectorTy->getElementType());
+		return d->irBuilder.CreateAlignedLoad(vectorTy, address, align);
+	}
+
+	if (name == "simdStore") {
+		if (args.size() != 2) {
+			std::cerr << "SIMD STORE NEEDS A DESTINATION AND A VECTOR FAIL!!!!!!!!!!!!!!!\n";
+			return nullptr;
+		}
+		auto vector = this->emit(args[1].get());
+		auto address = this->_emitSIMDAddress(args[0].get(), vector->getType());
+		auto elementTy = llvm::cast<llvm::FixedVectorType>(vector->getType())->getElementType();
+		auto align = d->llvmModule.getDataLayout().getABITypeAlign(elementTy);
+		return d->irBuilder.CreateAlignedStore(vector, address, align);
+	}
+
+	llvm::Value * first = this->emit(args[0].get());
+	if (!first) {
+		return nullptr;
+	}
+
+	if (name == "simdSelect") {
+		if (args.size() != 3) {
+			std::cerr << "SIMD SELECT NEEDS A MASK AND TWO VECTORS FAIL!!!!!!!!!!!!!!!\n";
+			return nullptr;
+		}
+		llvm::Value * condition = first;
+		auto maskTy = llvm::cast<llvm::FixedVectorType>(first->getType());
+		if (!maskTy->getElementType()->isIntegerTy(1)) {
+			condition = d->irBuilder.CreateICmpNE(first, llvm::Constant::getNullValue(maskTy), "simd.mask");
+		}
+		return d->irBuilder.CreateSelect(condition, this->emit(args[1].get()), this->emit(args[2].get()));
+	}
+
+	if (!llvm::isa<llvm::FixedVectorType>(first->getType())) {
+		std::cerr << "ARGUMENT OF " << name.data() << " IS NOT A VECTOR FAIL!!!!!!!!!!!!!!!\n";
+		return nullptr;
+	}
+	auto vectorTy = llvm::cast<llvm::FixedVectorType>(first->getType());
+	auto elementTy = vectorTy->getElementType();
+	bool isFloat = elementTy->isFloatingPointTy();
+
+	if (name == "simdLane") {
+		return d->irBuilder.CreateExtractElement(first, this->emit(args[1].get()));
+	}
+	if (name == "simdWithLane") {
+		auto scalar = this->_emitSIMDScalar(this->emit(args[2].get()), elementTy);
+		return d->irBuilder.CreateInsertElement(first, scalar, this->emit(args[1].get()));
+	}
+	if (name == "simdShuffle") {
+		std::vector<int> mask;
+		for (size_t i=2, j=args.size(); i<j; ++i) {
+			const auto & laneNode = args[i];
+			if (!laneNode->isA(NodeTypeNumberLiteral)) {
+				std::cerr << "SIMD SHUFFLE LANES MUST BE NUMBER LITERALS FAIL!!!!!!!!!!!!!!!\n";
+				return nullptr;
+			}
+			mask.push_back(std::static_pointer_cast<LILNumberLiteral>(laneNode)->getValue().toInt());
+		}
+		return d->irBuilder.CreateShuffleVector(first, this->emit(args[1].get()), mask);
+	}
+	if (name == "simdEqual" || name == "simdLessThan" || name == "simdGreaterThan") {
+		auto second = this->emit(args[1].get());
+		llvm::Value * compared;
+		if (name == "simdEqual") {
+			compared = isFloat ? d->irBuilder.CreateFCmpOEQ(first, second) : d->irBuilder.CreateICmpEQ(first, second);
+		} else if (name == "simdLessThan") {
+			compared = isFloat ? d->irBuilder.CreateFCmpOLT(first, second) : d->irBuilder.CreateICmpSLT(first, second);
+		} else {
+			compared = isFloat ? d->irBuilder.CreateFCmpOGT(first, second) : d->irBuilder.CreateICmpSGT(first, second);
+		}
+		//widen to all bits set in each true lane, like the mask registers of the hardware
+		auto laneTy = llvm::IntegerType::get(d->llvmContext, elementTy->getScalarSizeInBits());
+		return d->irBuilder.CreateSExt(compared, llvm::FixedVectorType::get(laneTy, vectorTy->getNumElements()), "simd.mask");
+	}
+	if (name == "simdReduceAdd") {
+		if (isFloat) {
+			//allow reassociation, so that the sum is done as a tree instead of lane by lane
+			auto sum = d->irBuilder.CreateFAddReduce(llvm::ConstantFP::get(elementTy, -0.0), first);
+			llvm::cast<llvm::Instruction>(sum)->setHasAllowReassoc(true);
+			return sum;
+		}
+		return d->irBuilder.CreateAddReduce(first);
+	}
+	if (name == "simdReduceMin") {
+		return isFloat ? d->irBuilder.CreateFPMinReduce(first) : d->irBuilder.CreateIntMinReduce(first, true);
+	}
+	if (name == "simdReduceMax") {
+		return isFloat ? d->irBuilder.CreateFPMaxReduce(first) : d->irBuilder.CreateIntMaxReduce(first, true);
+	}
+	if (name == "simdSqrt") {
+		if (!isFloat) {
+			std::cerr << "SIMD SQRT NEEDS A FLOAT VECTOR FAIL!!!!!!!!!!!!!!!\n";
+			return nullptr;
+		}
+		return d->irBuilder.CreateUnaryIntrinsic(llvm::Intrinsic::sqrt, first);
+	}
+	if (name == "simdAbs") {
+		if (isFloat) {
+			return d->irBuilder.CreateUnaryIntrinsic(llvm::Intrinsic::fabs, first);
+		}
+		return d->irBuilder.CreateBinaryIntrinsic(llvm::Intrinsic::abs, first, d->irBuilder.getFalse());
+	}
+	if (name == "simdMin") {
+		return d->irBuilder.CreateBinaryIntrinsic(isFloat ? llvm::Intrinsic::minnum : llvm::Intrinsic::smin, first, this->emit(args[1].get()));
+	}
+	if (name == "simdMax") {
+		return d->irBuilder.CreateBinaryIntrinsic(isFloat ? llvm::Intrinsic::maxnum : llvm::Intrinsic::smax, first, this->emit(args[1].get()));
+	}
+	if (name == "simdFma") {
+		auto second = this->emit(args[1].get());
+		auto third = this->emit(args[2].get());
+		if (!isFloat) {
+			return d->irBuilder.CreateAdd(d->irBuilder.CreateMul(first, second), third);
+		}
+		return d->irBuilder.CreateIntrinsic(llvm::Intrinsic::fma, {vectorTy}, {first, second, third});
+	}
+
+	std::cerr << "UNKNOWN SIMD BUILTIN " << name.data() << " FAIL!!!!!!!!!!!!!!!\n";
+	return nullptr;
+}
+
+llvm::Value * LILIREmitter::_emitSIMDScalar(llvm::Value * value, llvm::Type * elementTy)
+{
+	auto valueTy = value->getType();
+	if (valueTy == elementTy) {
+		return value;
+	}
+	if (elementTy->isFloatingPointTy()) {
+		if (valueTy->isIntegerTy()) {
+			return d->irBuilder.CreateSIToFP(value, elementTy);
+		}
+		return d->irBuilder.CreateFPCast(value, elementTy);
+	}
+	if (valueTy->isFloatingPointTy()) {
+		return d->irBuilder.CreateFPToSI(value, elementTy);
+	}
+	return d->irBuilder.CreateSExtOrTrunc(value, elementTy);
+}
+
+llvm::Value * LILIREmitter::_emitSIMDAddress(LILNode * node, llvm::Type * vectorTy)
+{
+	//static arrays are read in place, pointers point at the first element
+	llvm::Value * address;
+	auto ty = node->getType();
+	if (ty && ty->isA(TypeTypeStaticArray)) {
+		address = this->emitPointer(node);
+	} else {
+		address = this->emit(node);
+	}
+	return d->irBuilder.CreatePointerCast(address, vectorTy->getPointerTo());
+}
+
+llvm::Value * LILIREmitter::_emitAtomicCall(LILFunctionCall * value)
+{
+	const auto & name = value->getName();
+	const auto & args = value->getArguments();
+	auto ordering = this->_atomicOrderingForCall(value);
+	if (name == "atomicFence") {
+		if (ordering == llvm::AtomicOrdering::Monotonic) {
+			std::cerr << "A RELAXED FENCE DOES NOTHING FAIL!!!!!!!!!!!!!!!\n";
+			return nullptr;
 		}
-		
-		if (!fcArgIr) {
-			std::cerr << "!!!!!!!!!!ARG CODEGEN FAIL!!!!!!!!!!!!!!!\n";
+		return d->irBuilder.CreateFence(ordering);
+	}
+	if (args.size() < LILFunctionCall::atomicArgumentCount(name)) {
+		std::cerr << "WRONG NUMBER OF ARGUMENTS IN CALL TO " << name.data() << " FAIL!!!!!!!!!!!!!!!\n";
+		return nullptr;
+	}
+	auto addressTy = args[0]->getType();
+	if (!addressTy || !addressTy->isA(TypeTypePointer)) {
+		std::cerr << "FIRST ARG OF " << name.data() << " IS NOT A POINTER FAIL!!!!!!!!!!!!!!!\n";
+		return nullptr;
+	}
+	auto valueTy = this->llvmTypeFromLILType(std::static_pointer_cast<LILPointerType>(addressTy)->getArgument().get());
+	bool isByteSizedInt = valueTy->isIntegerTy() && (valueTy->getIntegerBitWidth() % 8) == 0;
+	if (!isByteSizedInt && !valueTy->isPointerTy() && !valueTy->isFloatingPointTy()) {
+		std::cerr << "ATOMIC OPERATIONS ONLY WORK ON NUMBERS AND POINTERS FAIL!!!!!!!!!!!!!!!\n";
+		return nullptr;
+	}
+	auto address = d->irBuilder.CreatePointerCast(this->emit(args[0].get()), valueTy->getPointerTo());
+	//atomics need natural alignment, which is what fields and allocations get anyway
+	auto align = d->llvmModule.getDataLayout().getABITypeAlign(valueTy);
+
+	if (name == "atomicLoad") {
+		if (ordering == llvm::AtomicOrdering::Release || ordering == llvm::AtomicOrdering::AcquireRelease) {
+			std::cerr << "AN ATOMIC LOAD CAN NOT HAVE RELEASE ORDERING FAIL!!!!!!!!!!!!!!!\n";
 			return nullptr;
-		} else {
-			argsvect.push_back(fcArgIr);
 		}
+		auto load = d->irBuilder.CreateAlignedLoad(valueTy, address, align, "atomic.load");
+		load->setAtomic(ordering);
+		return load;
 	}
-	
-	auto llvmTy = this->llvmTypeFromLILType(fnTy);
-	if (llvmTy->getTypeID() != llvm::Type::FunctionTyID) {
-		std::cerr << "TYPE OF CALL WAS NOT FUNCTION TYPE FAIL!!!!!!!!!!!!!!!\n";
+	if (name == "atomicStore") {
+		if (ordering == llvm::AtomicOrdering::Acquire || ordering == llvm::AtomicOrdering::AcquireRelease) {
+			std::cerr << "AN ATOMIC STORE CAN NOT HAVE ACQUIRE ORDERING FAIL!!!!!!!!!!!!!!!\n";
+			return nullptr;
+		}
+		auto store = d->irBuilder.CreateAlignedStore(this->_emitAtomicOperand(args[1].get(), valueTy), address, align);
+		store->setAtomic(ordering);
+		return store;
+	}
+	if (name == "atomicCompareExchange") {
+		auto expected = this->_emitAtomicOperand(args[1].get(), valueTy);
+		auto desired = this->_emitAtomicOperand(args[2].get(), valueTy);
+		auto failureOrdering = llvm::AtomicCmpXchgInst::getStrongestFailureOrdering(ordering);
+		auto cmpXchg = d->irBuilder.CreateAtomicCmpXchg(address, expected, desired, align, ordering, failureOrdering);
+		return d->irBuilder.CreateExtractValue(cmpXchg, 1, "atomic.success");
+	}
+
+	llvm::AtomicRMWInst::BinOp op;
+	bool isFloat = valueTy->isFloatingPointTy();
+	if (name == "atomicExchange") {
+		op = llvm::AtomicRMWInst::Xchg;
+	} else if (name == "atomicAdd") {
+		op = isFloat ? llvm::AtomicRMWInst::FAdd : llvm::AtomicRMWInst::Add;
+	} else if (name == "atomicSub") {
+		op = isFloat ? llvm::AtomicRMWInst::FSub : llvm::AtomicRMWInst::Sub;
+	} else if (isFloat || valueTy->isPointerTy()) {
+		std::cerr << "BITWISE ATOMIC OPERATIONS ONLY WORK ON INTEGERS FAIL!!!!!!!!!!!!!!!\n";
+		return nullptr;
+	} else if (name == "atomicAnd") {
+		op = llvm::AtomicRMWInst::And;
+	} else if (name == "atomicOr") {
+		op = llvm::AtomicRMWInst::Or;
+	} else if (name == "atomicXor") {
+		op = llvm::AtomicRMWInst::Xor;
+	} else {
+		std::cerr << "UNKNOWN ATOMIC BUILTIN " << name.data() << " FAIL!!!!!!!!!!!!!!!\n";
 		return nullptr;
 	}
-	return d->irBuilder.CreateCall(static_cast<llvm::FunctionType *>(llvmTy), fun, argsvect);
+	auto operand = this->_emitAtomicOperand(args[1].get(), valueTy);
+	if (!valueTy->isPointerTy()) {
+		return d->irBuilder.CreateAtomicRMW(op, address, operand, align, ordering);
+	}
+	//atomicrmw only takes integers, so pointers are exchanged or moved as intptr
+	auto intPtrTy = d->llvmModule.getDataLayout().getIntPtrType(valueTy);
+	auto intAddress = d->irBuilder.CreatePointerCast(address, intPtrTy->getPointerTo());
+	auto intOperand = d->irBuilder.CreatePtrToInt(operand, intPtrTy);
+	auto old = d->irBuilder.CreateAtomicRMW(op, intAddress, intOperand, align, ordering);
+	return d->irBuilder.CreateIntToPtr(old, valueTy);
+}
+
+llvm::Value * LILIREmitter::_emitAtomicOperand(LILNode * node, llvm::Type * valueTy)
+{
+	auto operand = this->emit(node);
+	if (!operand || operand->getType() == valueTy) {
+		return operand;
+	}
+	if (valueTy->isPointerTy()) {
+		if (operand->getType()->isIntegerTy()) {
+			return d->irBuilder.CreateIntToPtr(operand, valueTy);
+		}
+		return d->irBuilder.CreatePointerCast(operand, valueTy);
+	}
+	return this->_emitSIMDScalar(operand, valueTy);
+}
+
+llvm::AtomicOrdering LILIREmitter::_atomicOrderingForCall(LILFunctionCall * value) const
+{
+	const auto & args = value->getArguments();
+	if (args.size() <= LILFunctionCall::atomicArgumentCount(value->getName())) {
+		return llvm::AtomicOrdering::SequentiallyConsistent;
+	}
+	const auto & orderNode = args.back();
+	if (!orderNode->isA(NodeTypeStringLiteral)) {
+		return llvm::AtomicOrdering::SequentiallyConsistent;
+	}
+	auto orderStr = std::static_pointer_cast<LILStringLiteral>(orderNode)->getValue().stripQuotes();
+	if (orderStr == "relaxed") {
+		return llvm::AtomicOrdering::Monotonic;
+	} else if (orderStr == "acquire") {
+		return llvm::AtomicOrdering::Acquire;
+	} else if (orderStr == "release") {
+		return llvm::AtomicOrdering::Release;
+	} else if (orderStr == "acq_rel") {
+		return llvm::AtomicOrdering::AcquireRelease;
+	}
+	return llvm::AtomicOrdering::SequentiallyConsistent;
 }
 
 llvm::Value * LILIREmitter::_emitFlowC(LILFlowControl * value)
@@ -3891,6 +5097,7 @@ llvm::Value * LILIREmitter::_emitIf(LILFlowControl * value)
 
 	//configure the body of the if
 	d->irBuilder.SetInsertPoint(bodyBB);
+	this->pushLifetimeScope();
 
 	bool hasReturn = false;
 	bool hasBreak = false;
@@ -3907,13 +5114,18 @@ llvm::Value * LILIREmitter::_emitIf(LILFlowControl * value)
 		}
 	}
 	if (hasReturn) {
+		this->popLifetimeScope(false);
 		d->irBuilder.CreateBr(d->finallyBB);
-	} else if (!hasBreak) {
+	} else if (hasBreak) {
+		this->popLifetimeScope(false);
+	} else {
+		this->popLifetimeScope();
 		d->irBuilder.CreateBr(mergeBB);
 	}
 
 	fun->getBasicBlockList().push_back(elseBB);
 	d->irBuilder.SetInsertPoint(elseBB);
+	this->pushLifetimeScope();
 
 	hasReturn = false;
 	hasBreak = false;
@@ -3930,8 +5142,12 @@ llvm::Value * LILIREmitter::_emitIf(LILFlowControl * value)
 		}
 	}
 	if (hasReturn) {
+		this->popLifetimeScope(false);
 		d->irBuilder.CreateBr(d->finallyBB);
-	} else if (!hasBreak) {
+	} else if (hasBreak) {
+		this->popLifetimeScope(false);
+	} else {
+		this->popLifetimeScope();
 		d->irBuilder.CreateBr(mergeBB);
 	}
 
@@ -4095,13 +5311,13 @@ llvm::Value * LILIREmitter::_emitIfCastConditionForNullable(bool negated, LILTyp
 	}
 	else if (ty->isA(TypeTypePointer))
 	{
+		//null is the niche, so the check is a plain compare of the pointer itself
 		llvm::Value * ir = this->emit(val);
-		auto temp = d->irBuilder.CreatePtrToInt(ir, llvm::Type::getInt64Ty(d->llvmContext));
-		auto nullValue = llvm::ConstantInt::get(d->llvmContext, llvm::APInt(64, 0, false));
+		auto nullValue = llvm::ConstantPointerNull::get(llvm::cast<llvm::PointerType>(ir->getType()));
 		if (negated) {
-			ret = d->irBuilder.CreateICmpEQ(temp, nullValue, "if.cond");
+			ret = d->irBuilder.CreateICmpEQ(ir, nullValue, "if.cond");
 		} else {
-			ret = d->irBuilder.CreateICmpNE(temp, nullValue, "if.cond");
+			ret = d->irBuilder.CreateICmpNE(ir, nullValue, "if.cond");
 		}
 	}
 	else if (
@@ -4145,6 +5361,9 @@ llvm::Value * LILIREmitter::_emitIfCastConditionForNullable(bool negated, LILTyp
 
 llvm::Value * LILIREmitter::_emitFor(LILFlowControl * value)
 {
+	if (value->getIsParallel()) {
+		return this->_emitParallelFor(value);
+	}
 	auto arguments = value->getArguments();
 	if (arguments.size() > 1) {
 		std::map<std::string, llvm::Value *> scope;
@@ -4157,6 +5376,19 @@ llvm::Value * LILIREmitter::_emitFor(LILFlowControl * value)
 		if (!condNode) {
 			return nullptr;
 		}
+
+		//the size is read once and the elements straight from the data pointer,
+		//the type validator turns this off for loops that change the object
+		llvm::Value * hoistedSize = nullptr;
+		std::shared_ptr<LILExpression> keyComparison;
+		if (value->getIteratesData() && condNode->isA(NodeTypeExpression)) {
+			auto dataPtr = this->_emitForDataPointer(value);
+			if (dataPtr) {
+				d->iterationData[value] = dataPtr;
+				keyComparison = std::static_pointer_cast<LILExpression>(condNode);
+				hoistedSize = this->emit(keyComparison->getRight().get());
+			}
+		}
 		
 		auto currentBB = d->irBuilder.GetInsertBlock();
 		auto fun = currentBB->getParent();
@@ -4164,10 +5396,16 @@ llvm::Value * LILIREmitter::_emitFor(LILFlowControl * value)
 		auto afterLoopBBBackup = d->afterLoopBB;
 		d->afterLoopBB = llvm::BasicBlock::Create(d->llvmContext, "for.after", fun);
 		
-		auto condition = this->emit(condNode.get());
+		llvm::Value * condition;
+		if (hoistedSize) {
+			condition = d->irBuilder.CreateICmpSLT(this->emit(keyComparison->getLeft().get()), hoistedSize, "for.cond");
+		} else {
+			condition = this->emit(condNode.get());
+		}
 		d->irBuilder.CreateCondBr(condition, loopBB, d->afterLoopBB);
 		
 		d->irBuilder.SetInsertPoint(loopBB);
+		this->pushLifetimeScope();
 		this->_emitEvaluables(value->getThen());
 		
 		if (arguments.size() == 3) {
@@ -4177,7 +5415,12 @@ llvm::Value * LILIREmitter::_emitFor(LILFlowControl * value)
 			}
 		}
 
-		auto condition2 = this->emit(condNode.get());
+		llvm::Value * condition2;
+		if (hoistedSize) {
+			condition2 = d->irBuilder.CreateICmpSLT(this->emit(keyComparison->getLeft().get()), hoistedSize, "for.cond");
+		} else {
+			condition2 = this->emit(condNode.get());
+		}
 		if (!condNode->isA(NodeTypeExpression)) {
 			switch (condition2->getType()->getTypeID()) {
 				case llvm::Type::IntegerTyID:
@@ -4199,7 +5442,9 @@ llvm::Value * LILIREmitter::_emitFor(LILFlowControl * value)
 			}
 		}
 
-		d->irBuilder.CreateCondBr(condition2, loopBB, d->afterLoopBB);
+		this->popLifetimeScope();
+		auto latch = d->irBuilder.CreateCondBr(condition2, loopBB, d->afterLoopBB);
+		this->_emitLoopHints(value, latch, loopBB);
 		
 		//restore hidden locals
 		const std::map<std::string, llvm::Value *> & hiddenLocals = d->hiddenLocals.back();
@@ -4207,6 +5452,7 @@ llvm::Value * LILIREmitter::_emitFor(LILFlowControl * value)
 			d->namedValues[it->first] = it->second;
 		}
 		d->hiddenLocals.pop_back();
+		d->iterationData.erase(value);
 
 		d->irBuilder.SetInsertPoint(d->afterLoopBB);
 
@@ -4220,6 +5466,205 @@ llvm::Value * LILIREmitter::_emitFor(LILFlowControl * value)
 	return nullptr;
 }
 
+llvm::Value * LILIREmitter::_emitForDataPointer(LILFlowControl * value)
+{
+	auto subjectNode = value->getSubject();
+	if (!subjectNode) {
+		return nullptr;
+	}
+	auto subjTy = subjectNode->getType();
+	if (!subjTy || subjTy->getTypeType() != TypeTypeObject) {
+		return nullptr;
+	}
+	auto cd = this->findClassWithName(subjTy->getName());
+	if (!cd) {
+		return nullptr;
+	}
+	auto meth = cd->getMethodNamed("data");
+	if (!meth || !meth->isA(NodeTypeFunctionDecl)) {
+		return nullptr;
+	}
+	auto fd = std::static_pointer_cast<LILFunctionDecl>(meth);
+	llvm::Function* fun = d->llvmModule.getFunction(fd->getName().data());
+	if (!fun) {
+		return nullptr;
+	}
+	std::vector<llvm::Value *> argsvect;
+	argsvect.push_back(this->emitPointer(subjectNode.get()));
+	return this->_emitCallWithAbi(fun->getFunctionType(), fun, fd->getFnType().get(), argsvect, "for.data");
+}
+
+//the body is outlined into a function of (env, start, end), where env holds pointers to the
+//locals of the enclosing function, and LIL__parallelFor (see std/thread.lil) hands out the ranges
+llvm::Value * LILIREmitter::_emitParallelFor(LILFlowControl * value)
+{
+	//only counted loops can be split, (var.i64 i: start; i < end; i +: 1)
+	const auto & arguments = value->getArguments();
+	std::shared_ptr<LILVarDecl> counterVd;
+	std::shared_ptr<LILNode> endNode;
+	if (
+		arguments.size() == 3
+		&& arguments[0]->isA(NodeTypeVarDecl)
+		&& arguments[1]->isA(NodeTypeExpression)
+		&& arguments[2]->isA(NodeTypeUnaryExpression)
+	) {
+		counterVd = std::static_pointer_cast<LILVarDecl>(arguments[0]);
+		auto comparison = std::static_pointer_cast<LILExpression>(arguments[1]);
+		auto step = std::static_pointer_cast<LILUnaryExpression>(arguments[2]);
+		auto left = comparison->getLeft();
+		auto stepSubject = step->getSubject();
+		auto stepValue = step->getValue();
+		if (
+			comparison->getExpressionType() == ExpressionTypeSmallerComparison
+			&& left && left->isA(NodeTypeVarName)
+			&& std::static_pointer_cast<LILVarName>(left)->getName() == counterVd->getName()
+			&& step->getUnaryExpressionType() == UnaryExpressionTypeSum
+			&& stepSubject && stepSubject->isA(NodeTypeVarName)
+			&& std::static_pointer_cast<LILVarName>(stepSubject)->getName() == counterVd->getName()
+			&& stepValue && stepValue->isA(NodeTypeNumberLiteral)
+			&& std::static_pointer_cast<LILNumberLiteral>(stepValue)->getValue().toLongLong() == 1
+		) {
+			endNode = comparison->getRight();
+		}
+	}
+	std::shared_ptr<LILType> counterTy;
+	if (counterVd) {
+		counterTy = counterVd->getType();
+	}
+	if (!endNode || !counterVd->getInitVal() || !counterTy || !LILType::isIntegerType(counterTy.get())) {
+		std::cerr << "#parallel NEEDS A COUNTED FOR LOOP FAIL!!!!!!!!!!!!!!!\n\n";
+		return nullptr;
+	}
+
+	LILString parallelFnName = "LIL__parallelFor";
+	auto parallelFnNode = this->findNodeForName(parallelFnName, value->getParentNode().get());
+	if (!parallelFnNode || !parallelFnNode->isA(NodeTypeFunctionDecl)) {
+		std::cerr << "PARALLEL FOR FUNCTION NOT FOUND FAIL!!!!!!!!!!!!!!!\n\n";
+		return nullptr;
+	}
+	auto parallelFd = std::static_pointer_cast<LILFunctionDecl>(parallelFnNode);
+	llvm::Function * parallelFun = this->_emitFnSignature(parallelFd->getName().data(), parallelFd->getFnType().get());
+
+	auto i64Ty = d->irBuilder.getInt64Ty();
+	auto i8PtrTy = d->irBuilder.getInt8PtrTy();
+	auto counterLlvmTy = this->llvmTypeFromLILType(counterTy.get());
+
+	//the bounds are evaluated once, before the ranges are handed out
+	auto startVal = d->irBuilder.CreateSExtOrTrunc(this->emit(counterVd->getInitVal().get()), i64Ty);
+	auto endVal = d->irBuilder.CreateSExtOrTrunc(this->emit(endNode.get()), i64Ty);
+
+	//capture the locals of the enclosing function by reference, values that are not
+	//pointers (like the arguments of rule functions) are spilled to the stack first
+	auto currentFun = d->irBuilder.GetInsertBlock()->getParent();
+	std::vector<std::pair<std::string, llvm::Value *>> captures;
+	for (const auto & it : d->namedValues) {
+		auto namedValue = it.second;
+		if (!namedValue) {
+			continue;
+		}
+		auto instr = llvm::dyn_cast<llvm::Instruction>(namedValue);
+		auto arg = llvm::dyn_cast<llvm::Argument>(namedValue);
+		if ((instr && instr->getFunction() == currentFun) || (arg && arg->getParent() == currentFun)) {
+			captures.push_back(it);
+		}
+	}
+	auto envTy = llvm::ArrayType::get(i8PtrTy, captures.size());
+	auto env = this->createTemporaryAlloca(envTy, "parallel.env");
+	for (size_t i = 0, j = captures.size(); i < j; ++i) {
+		llvm::Value * captured = captures[i].second;
+		if (!captured->getType()->isPointerTy()) {
+			auto spill = this->createTemporaryAlloca(captured->getType(), captures[i].first);
+			d->irBuilder.CreateStore(captured, spill);
+			captured = spill;
+		}
+		auto slot = d->irBuilder.CreateConstGEP2_32(envTy, env, 0, i);
+		d->irBuilder.CreateStore(d->irBuilder.CreateBitCast(captured, i8PtrTy), slot);
+	}
+
+	//the outlined body
+	auto bodyFnTy = llvm::FunctionType::get(d->irBuilder.getVoidTy(), { i8PtrTy, i64Ty, i64Ty }, false);
+	auto bodyFun = llvm::Function::Create(bodyFnTy, llvm::Function::InternalLinkage, "_lil_parallel_" + currentFun->getName().str(), &d->llvmModule);
+
+	auto insertPointBackup = d->irBuilder.saveIP();
+	auto namedValuesBackup = d->namedValues;
+	auto returnAllocaBackup = d->returnAlloca;
+	auto needsReturnValueBackup = d->needsReturnValue;
+	auto finallyBBBackup = d->finallyBB;
+	auto afterLoopBBBackup = d->afterLoopBB;
+	std::vector<std::vector<llvm::AllocaInst *>> lifetimeScopesBackup;
+	std::swap(lifetimeScopesBackup, d->lifetimeScopes);
+	d->returnAlloca = nullptr;
+	d->needsReturnValue = false;
+	d->finallyBB = nullptr;
+
+	auto entryBB = llvm::BasicBlock::Create(d->llvmContext, "entry", bodyFun);
+	d->irBuilder.SetInsertPoint(entryBB);
+	auto envArg = bodyFun->getArg(0);
+	auto startArg = bodyFun->getArg(1);
+	auto endArg = bodyFun->getArg(2);
+	auto envPtr = d->irBuilder.CreateBitCast(envArg, envTy->getPointerTo());
+	for (size_t i = 0, j = captures.size(); i < j; ++i) {
+		const auto & name = captures[i].first;
+		llvm::Value * captured = captures[i].second;
+		auto slot = d->irBuilder.CreateConstGEP2_32(envTy, envPtr, 0, i);
+		auto pointer = d->irBuilder.CreateLoad(i8PtrTy, slot);
+		if (captured->getType()->isPointerTy()) {
+			d->namedValues[name] = d->irBuilder.CreateBitCast(pointer, captured->getType(), name);
+		} else {
+			auto spillPtr = d->irBuilder.CreateBitCast(pointer, captured->getType()->getPointerTo());
+			d->namedValues[name] = d->irBuilder.CreateLoad(captured->getType(), spillPtr, name);
+		}
+	}
+	std::string counterName = counterVd->getName().data();
+	auto counterAlloca = this->createEntryBlockAlloca(bodyFun, counterName, counterLlvmTy);
+	d->irBuilder.CreateStore(d->irBuilder.CreateSExtOrTrunc(startArg, counterLlvmTy), counterAlloca);
+	d->namedValues[counterName] = counterAlloca;
+
+	auto loopBB = llvm::BasicBlock::Create(d->llvmContext, "loop", bodyFun);
+	d->afterLoopBB = llvm::BasicBlock::Create(d->llvmContext, "for.after", bodyFun);
+	d->irBuilder.CreateCondBr(d->irBuilder.CreateICmpSLT(startArg, endArg), loopBB, d->afterLoopBB);
+
+	d->irBuilder.SetInsertPoint(loopBB);
+	d->hiddenLocals.push_back(std::map<std::string, llvm::Value *>());
+	this->pushLifetimeScope();
+	this->_emitEvaluables(value->getThen());
+	auto current = d->irBuilder.CreateLoad(counterLlvmTy, counterAlloca);
+	auto next = d->irBuilder.CreateAdd(current, llvm::ConstantInt::get(counterLlvmTy, 1));
+	d->irBuilder.CreateStore(next, counterAlloca);
+	auto condition = d->irBuilder.CreateICmpSLT(d->irBuilder.CreateSExtOrTrunc(next, i64Ty), endArg, "for.cond");
+	this->popLifetimeScope();
+	auto latch = d->irBuilder.CreateCondBr(condition, loopBB, d->afterLoopBB);
+	this->_emitLoopHints(value, latch, loopBB);
+	d->hiddenLocals.pop_back();
+
+	d->irBuilder.SetInsertPoint(d->afterLoopBB);
+	d->irBuilder.CreateRetVoid();
+
+	llvm::verifyFunction(*bodyFun);
+	this->_checkAllocasInEntryBlock(bodyFun, value);
+#ifdef LILIREMITTEROPTIMIZE
+	d->functionPassManager->run(*bodyFun);
+#endif
+
+	//back to the enclosing function
+	d->irBuilder.restoreIP(insertPointBackup);
+	d->namedValues = namedValuesBackup;
+	d->returnAlloca = returnAllocaBackup;
+	d->needsReturnValue = needsReturnValueBackup;
+	d->finallyBB = finallyBBBackup;
+	d->afterLoopBB = afterLoopBBBackup;
+	std::swap(lifetimeScopesBackup, d->lifetimeScopes);
+
+	auto parallelFnTy = parallelFun->getFunctionType();
+	std::vector<llvm::Value *> args;
+	args.push_back(d->irBuilder.CreateBitCast(bodyFun, parallelFnTy->getParamType(0)));
+	args.push_back(d->irBuilder.CreateBitCast(env, parallelFnTy->getParamType(1)));
+	args.push_back(startVal);
+	args.push_back(endVal);
+	d->irBuilder.CreateCall(parallelFnTy, parallelFun, args);
+	return nullptr;
+}
+
 llvm::Value * LILIREmitter::_emitLoop(LILFlowControl * value)
 {
 	auto currentBB = d->irBuilder.GetInsertBlock();
@@ -4230,6 +5675,7 @@ llvm::Value * LILIREmitter::_emitLoop(LILFlowControl * value)
 
 	d->irBuilder.CreateBr(loopBB);
 	d->irBuilder.SetInsertPoint(loopBB);
+	this->pushLifetimeScope();
 	
 	auto condVd = std::make_shared<LILVarDecl>();
 	condVd->setParentNode(value->shared_from_this());
@@ -4260,13 +5706,95 @@ llvm::Value * LILIREmitter::_emitLoop(LILFlowControl * value)
 	exp->setRight(rightVal);
 	auto condition = this->emit(exp.get());
 
-	d->irBuilder.CreateCondBr(condition, loopBB, d->afterLoopBB);
+	this->popLifetimeScope();
+	auto latch = d->irBuilder.CreateCondBr(condition, loopBB, d->afterLoopBB);
+	this->_emitLoopHints(value, latch, loopBB);
 	d->irBuilder.SetInsertPoint(d->afterLoopBB);
 
 	d->afterLoopBB = afterLoopBBBackup;
 	return nullptr;
 }
 
+//attaches the llvm.loop metadata for the hints of the loop to its latch
+void LILIREmitter::_emitLoopHints(LILFlowControl * value, llvm::BranchInst * latch, llvm::BasicBlock * loopBB)
+{
+	if (!value->hasLoopHints()) {
+		return;
+	}
+	auto & context = d->llvmContext;
+	std::vector<llvm::Metadata *> loopOps;
+	//the first operand points back at the loop id itself
+	loopOps.push_back(nullptr);
+	LILString remark;
+
+	auto unrollCount = value->getUnrollCount();
+	if (unrollCount > 0) {
+		loopOps.push_back(llvm::MDNode::get(context, {
+			llvm::MDString::get(context, "llvm.loop.unroll.count"),
+			llvm::ConstantAsMetadata::get(d->irBuilder.getInt32(unrollCount))
+		}));
+		remark += " unroll(" + LILString::number((LILUnitI64)unrollCount) + ")";
+	} else if (unrollCount < 0) {
+		loopOps.push_back(llvm::MDNode::get(context, { llvm::MDString::get(context, "llvm.loop.unroll.enable") }));
+		remark += " unroll";
+	}
+
+	auto vectorizeWidth = value->getVectorizeWidth();
+	if (vectorizeWidth != 0) {
+		loopOps.push_back(llvm::MDNode::get(context, {
+			llvm::MDString::get(context, "llvm.loop.vectorize.enable"),
+			llvm::ConstantAsMetadata::get(d->irBuilder.getTrue())
+		}));
+		if (vectorizeWidth > 0) {
+			loopOps.push_back(llvm::MDNode::get(context, {
+				llvm::MDString::get(context, "llvm.loop.vectorize.width"),
+				llvm::ConstantAsMetadata::get(d->irBuilder.getInt32(vectorizeWidth))
+			}));
+			remark += " vectorize(" + LILString::number((LILUnitI64)vectorizeWidth) + ")";
+		} else {
+			remark += " vectorize";
+		}
+	}
+
+	if (value->getIsIndependent()) {
+		//all memory accesses of the body go into one access group, which the loop declares as parallel
+		//locals are left out, since the loop counter and other variables do carry over between iterations
+		auto accessGroup = llvm::MDNode::getDistinct(context, llvm::None);
+		auto fun = loopBB->getParent();
+		for (auto it = loopBB->getIterator(); it != fun->end(); ++it) {
+			if (&(*it) == d->afterLoopBB) {
+				continue;
+			}
+			for (auto & instr : *it) {
+				llvm::Value * address = nullptr;
+				if (auto load = llvm::dyn_cast<llvm::LoadInst>(&instr)) {
+					address = load->getPointerOperand();
+				} else if (auto store = llvm::dyn_cast<llvm::StoreInst>(&instr)) {
+					address = store->getPointerOperand();
+				}
+				if (!address || llvm::isa<llvm::AllocaInst>(llvm::getUnderlyingObject(address))) {
+					continue;
+				}
+				auto existing = instr.getMetadata(llvm::LLVMContext::MD_access_group);
+				instr.setMetadata(llvm::LLVMContext::MD_access_group, llvm::uniteAccessGroups(existing, accessGroup));
+			}
+		}
+		loopOps.push_back(llvm::MDNode::get(context, {
+			llvm::MDString::get(context, "llvm.loop.parallel_accesses"),
+			accessGroup
+		}));
+		remark += " noalias";
+	}
+
+	auto loopID = llvm::MDNode::getDistinct(context, loopOps);
+	loopID->replaceOperandWith(0, loopID);
+	latch->setMetadata(llvm::LLVMContext::MD_loop, loopID);
+
+	if (d->loopRemarks) {
+		std::cerr << "loop hints in " << latch->getFunction()->getName().str() << " at line " << value->getSourceLocation().line << ":" << remark.data() << "\n";
+	}
+}
+
 llvm::Value * LILIREmitter::_emitFlowCCall(LILFlowControlCall * value)
 {
 	switch (value->getFlowControlCallType()) {
@@ -4397,17 +5925,25 @@ llvm::Value * LILIREmitter::_emitValList(LILValueList * value)
 	auto ty = value->getType();
 	auto llvmTy = this->llvmTypeFromLILType(ty.get());
 	if (ty->isA(TypeTypeStaticArray)) {
-		//FIXME: optimize this into a global and memcpy when profitable
-		size_t i = 0;
-		for (auto node : value->getValues()) {
-			d->currentAlloca = this->_emitGEP(allocaBackup, llvmTy, false, 0, "", true, true, i);
-			auto ir = this->emit(node.get());
-			if (ir != nullptr) {
-				auto gep = this->_emitGEP(allocaBackup, llvmTy, false, 0, "", true, true, i);
-				this->_convertLlvmValueIfNeeded(&ir, ty->getType().get(), node->getType().get());
-				d->irBuilder.CreateStore(ir, gep);
+		auto constInit = this->_emitConstantInitializer(value, ty.get());
+		if (constInit) {
+			//copy the literals out of constant data instead of storing them one by one
+			auto globalDeclaration = new llvm::GlobalVariable(d->llvmModule, llvmTy, true, llvm::GlobalVariable::PrivateLinkage, constInit, "table");
+			globalDeclaration->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+			auto size = d->llvmModule.getDataLayout().getTypeAllocSize(llvmTy);
+			d->irBuilder.CreateMemCpy(allocaBackup, llvm::MaybeAlign(), globalDeclaration, llvm::MaybeAlign(), size);
+		} else {
+			size_t i = 0;
+			for (auto node : value->getValues()) {
+				d->currentAlloca = this->_emitGEP(allocaBackup, llvmTy, false, 0, "", true, true, i);
+				auto ir = this->emit(node.get());
+				if (ir != nullptr) {
+					auto gep = this->_emitGEP(allocaBackup, llvmTy, false, 0, "", true, true, i);
+					this->_convertLlvmValueIfNeeded(&ir, ty->getType().get(), node->getType().get());
+					d->irBuilder.CreateStore(ir, gep);
+				}
+				i += 1;
 			}
-			i += 1;
 		}
 	} else if (ty->isA(TypeTypeObject) && ty->getName().substr(0, 9) == "lil_array") {
 		auto cd = this->findClassWithName(ty->getName());
@@ -4462,7 +5998,13 @@ llvm::Value * LILIREmitter::_emitValList(LILValueList * value)
 						return nullptr;
 					}
 
-					if (valuesSize <= LIL_ARRAY_SMALL_BUFFER_SIZE) {
+					//the inline capacity comes from the sbuf alias of the class, which is configurable
+					size_t inlineCapacity = 0;
+					auto saLlvmTy = this->llvmTypeFromLILType(saTy.get());
+					if (saLlvmTy && saLlvmTy->isArrayTy()) {
+						inlineCapacity = saLlvmTy->getArrayNumElements();
+					}
+					if (valuesSize <= inlineCapacity) {
 						d->currentAlloca = this->_emitGEP(d->currentAlloca, llvmTy, true, index, fldName, true, false, 0);
 						value->setType(saTy);
 						this->emitForMultipleType(value, std::static_pointer_cast<LILMultipleType>(fldTy));
@@ -4519,18 +6061,142 @@ llvm::Value * LILIREmitter::_emitValList(LILValueList * value)
 			index += 1;
 		}
 	} else if (ty->isA(TypeTypeSIMD)) {
-		std::vector<llvm::Constant *> values;
+		//the builder folds this back into a constant vector when all the lanes are constants
+		auto vectorTy = llvm::cast<llvm::FixedVectorType>(this->llvmTypeFromLILType(ty.get()));
+		llvm::Value * vector = llvm::UndefValue::get(vectorTy);
+		uint64_t lane = 0;
 		for (auto node : value->getValues()) {
-			auto irVal = this->emit(node.get());
-			values.push_back(llvm::cast<llvm::Constant>(irVal));
+			auto irVal = this->_emitSIMDScalar(this->emit(node.get()), vectorTy->getElementType());
+			vector = d->irBuilder.CreateInsertElement(vector, irVal, lane);
+			lane += 1;
 		}
-		d->irBuilder.CreateStore(llvm::ConstantVector::get(values), d->currentAlloca);
+		d->irBuilder.CreateStore(vector, d->currentAlloca);
 		
 	}
 	d->currentAlloca = allocaBackup;
 	return nullptr;
 }
 
+//builds the value out of literals alone, gives back null when code has to run to make it
+llvm::Constant * LILIREmitter::_emitConstantInitializer(LILNode * node, LILType * ty)
+{
+	auto llvmTy = this->llvmTypeFromLILType(ty);
+	auto nodeTy = node->getType();
+	if (!llvmTy || !nodeTy) {
+		return nullptr;
+	}
+	switch (node->getNodeType()) {
+		case NodeTypeNumberLiteral:
+		case NodeTypeBoolLiteral:
+		{
+			if (!ty->isA(TypeTypeSingle) || nodeTy->getName() != ty->getName()) {
+				return nullptr;
+			}
+			auto value = this->emit(node);
+			if (!value || !llvm::isa<llvm::Constant>(value) || value->getType() != llvmTy) {
+				return nullptr;
+			}
+			return llvm::cast<llvm::Constant>(value);
+		}
+		case NodeTypeStringLiteral:
+		{
+			auto str = static_cast<LILStringLiteral *>(node);
+			if (!str->getIsCString()) {
+				return nullptr;
+			}
+			auto value = this->_emitStr(str);
+			if (!value || !llvm::isa<llvm::Constant>(value) || value->getType() != llvmTy) {
+				return nullptr;
+			}
+			return llvm::cast<llvm::Constant>(value);
+		}
+		case NodeTypeValueList:
+		{
+			if (!ty->isA(TypeTypeStaticArray) || !llvmTy->isArrayTy()) {
+				return nullptr;
+			}
+			auto elementTy = static_cast<LILStaticArrayType *>(ty)->getType();
+			auto arrayTy = llvm::cast<llvm::ArrayType>(llvmTy);
+			auto values = static_cast<LILValueList *>(node)->getValues();
+			if (!elementTy || values.size() > arrayTy->getNumElements()) {
+				return nullptr;
+			}
+			std::vector<llvm::Constant *> elements;
+			for (auto value : values) {
+				auto element = this->_emitConstantInitializer(value.get(), elementTy.get());
+				if (!element) {
+					return nullptr;
+				}
+				elements.push_back(element);
+			}
+			//the slots after the last value stay zeroed
+			while (elements.size() < arrayTy->getNumElements()) {
+				elements.push_back(llvm::Constant::getNullValue(arrayTy->getElementType()));
+			}
+			return llvm::ConstantArray::get(arrayTy, elements);
+		}
+		case NodeTypeObjectDefinition:
+		{
+			if (!llvmTy->isStructTy() || nodeTy->getName() != ty->getName()) {
+				return nullptr;
+			}
+			auto classValue = this->findClassWithName(ty->getName());
+			//constructors and setters need code to run
+			if (!classValue || classValue->getMethodNamed("construct")) {
+				return nullptr;
+			}
+			auto objDef = static_cast<LILObjectDefinition *>(node);
+			std::vector<llvm::Constant *> fieldValues;
+			for (const auto & field : classValue->getFields()) {
+				auto vd = std::static_pointer_cast<LILVarDecl>(field);
+				auto vdTy = vd->getType();
+				if (vd->getIsVVar() || !vdTy || vdTy->isA(TypeTypeMultiple) || vdTy->getIsNullable()) {
+					return nullptr;
+				}
+				std::shared_ptr<LILNode> theVal;
+				for (auto objNode : objDef->getNodes()) {
+					if (!objNode->isA(NodeTypeAssignment)) {
+						return nullptr;
+					}
+					auto subj = std::static_pointer_cast<LILAssignment>(objNode)->getSubject();
+					if (!subj || !subj->isA(NodeTypePropertyName)) {
+						return nullptr;
+					}
+					if (std::static_pointer_cast<LILPropertyName>(subj)->getName() == vd->getName()) {
+						theVal = std::static_pointer_cast<LILAssignment>(objNode)->getValue();
+						break;
+					}
+				}
+				if (!theVal) {
+					theVal = vd->getInitVal();
+				}
+				llvm::Constant * fieldValue;
+				if (theVal) {
+					fieldValue = this->_emitConstantInitializer(theVal.get(), vdTy.get());
+					if (!fieldValue) {
+						return nullptr;
+					}
+				} else {
+					fieldValue = llvm::Constant::getNullValue(this->llvmTypeFromLILType(vdTy.get()));
+				}
+				fieldValues.push_back(fieldValue);
+			}
+			auto structTy = llvm::cast<llvm::StructType>(llvmTy);
+			if (fieldValues.size() != structTy->getNumElements()) {
+				return nullptr;
+			}
+			for (size_t i=0, j=fieldValues.size(); i<j; i+=1) {
+				if (fieldValues[i]->getType() != structTy->getElementType(i)) {
+					return nullptr;
+				}
+			}
+			return llvm::ConstantStruct::get(structTy, fieldValues);
+		}
+		default:
+			return nullptr;
+	}
+}
+
 void LILIREmitter::receiveLLVMIRData(llvm::LLVMIRParserEvent eventType, std::string data)
 {
 	switch (eventType) {
@@ -4591,7 +6257,7 @@ llvm::Value * LILIREmitter::emitPointer(LILNode * node)
 		case NodeTypeFunctionCall:
 		{
 			auto fc = static_cast<LILFunctionCall *>(node);
-			d->currentAlloca = d->irBuilder.CreateAlloca(this->llvmTypeFromLILType(fc->getReturnType().get()));
+			d->currentAlloca = this->createTemporaryAlloca(this->llvmTypeFromLILType(fc->getReturnType().get()));
 			auto returnVal = this->_emitFC(fc);
 			d->irBuilder.CreateStore(returnVal, d->currentAlloca);
 			return d->currentAlloca;
@@ -4772,6 +6438,20 @@ llvm::Value * LILIREmitter::_emitPointer(LILValuePath * value)
 							currentTy = saTy->getType();
 							break;
 						}
+						case TypeTypePointer:
+						{
+							auto ptrTy = std::static_pointer_cast<LILPointerType>(currentTy);
+							auto ptrArgTy = ptrTy->getArgument();
+							auto argIr = this->emit(arg.get());
+							if (!argIr) {
+								std::cerr << "CODEGEN OF ARGUMENT OF INDEX ACCESSOR FAILED!!!!!!!!!!!!!!!!\n";
+								return nullptr;
+							}
+							auto pointer = d->irBuilder.CreateLoad(this->llvmTypeFromLILType(currentTy.get()), llvmSubject);
+							llvmSubject = d->irBuilder.CreateGEP(this->llvmTypeFromLILType(ptrArgTy.get()), pointer, argIr);
+							currentTy = ptrArgTy;
+							break;
+						}
 						default:
 							std::cerr << "!!!!!!!!UNIMPLEMENTED FAIL!!!!!!!!!!!!!!!!\n";
 							return nullptr;
@@ -5015,11 +6695,56 @@ llvm::AllocaInst * LILIREmitter::createEntryBlockAlloca(llvm::Function * fun, co
 	return tmpBuilder.CreateAlloca(llvmType, 0, name.c_str());
 }
 
+llvm::AllocaInst * LILIREmitter::createTemporaryAlloca(llvm::Type * llvmType, const std::string & name)
+{
+	//always in the entry block, so that loops don't grow the stack and mem2reg can promote it
+	llvm::Function * fun = d->irBuilder.GetInsertBlock()->getParent();
+	llvm::AllocaInst * alloca = this->createEntryBlockAlloca(fun, name, llvmType);
+	if (d->lifetimeScopes.size() > 0) {
+		d->irBuilder.CreateLifetimeStart(alloca);
+		d->lifetimeScopes.back().push_back(alloca);
+	}
+	return alloca;
+}
+
+void LILIREmitter::pushLifetimeScope()
+{
+	d->lifetimeScopes.push_back(std::vector<llvm::AllocaInst *>());
+}
+
+void LILIREmitter::popLifetimeScope(bool emitEnd)
+{
+	if (d->lifetimeScopes.size() == 0) {
+		std::cerr << "LIFETIME SCOPE UNDERFLOW FAIL!!!!!!!!!!!!!!!\n\n";
+		return;
+	}
+	//paths that leave early (return, break) skip the end, which only keeps the slot alive longer
+	if (emitEnd) {
+		for (auto alloca : d->lifetimeScopes.back()) {
+			d->irBuilder.CreateLifetimeEnd(alloca);
+		}
+	}
+	d->lifetimeScopes.pop_back();
+}
+
 void LILIREmitter::setDebug(bool value)
 {
 	this->_debug = value;
 }
 
+void LILIREmitter::setTargetMachine(llvm::TargetMachine * targetMachine)
+{
+	this->_createFunctionPassManager(targetMachine);
+}
+
+void LILIREmitter::setLoopRemarks(bool value)
+{
+	d->loopRemarks = value;
+	if (value) {
+		d->llvmContext.setDiagnosticHandler(std::make_unique<LILLoopRemarkHandler>());
+	}
+}
+
 llvm::StructType * LILIREmitter::extractStructFromClass(LILClassDecl * value)
 {
 	auto name = value->getName().data();
@@ -5272,7 +6997,7 @@ llvm::Value * LILIREmitter::emitMultiTyToMultiTyConversion(LILNode * node, LILMu
 	llvm::Function * fun = d->irBuilder.GetInsertBlock()->getParent();
 
 	auto i8Ty = llvm::Type::getInt8Ty(d->llvmContext);
-	auto indexAlloca = d->irBuilder.CreateAlloca(i8Ty);
+	auto indexAlloca = this->createTemporaryAlloca(i8Ty);
 
 	auto mtValue = this->emitPointer(node);
 	std::vector<llvm::Value *> mtGepIndices;
@@ -5341,11 +7066,15 @@ llvm::Value * LILIREmitter::emitMultiTyToMultiTyConversion(LILNode * node, LILMu
 llvm::Value * LILIREmitter::emitUnwrappedFromMT(LILNode *node, LILType *targetTy)
 {
 	auto wrappedVal = this->emitPointer(node);
+	if (!wrappedVal) {
+		return nullptr;
+	}
 	std::vector<llvm::Value *> gepIndices;
 	auto llvmTy = this->llvmTypeFromLILType(targetTy);
+	auto llvmMultiTy = this->llvmTypeFromLILType(node->getType().get());
 	gepIndices.push_back(llvm::ConstantInt::get(d->llvmContext, llvm::APInt(LIL_GEP_INDEX_SIZE, 0, false)));
 	gepIndices.push_back(llvm::ConstantInt::get(d->llvmContext, llvm::APInt(LIL_GEP_INDEX_SIZE, 0, false)));
-	auto gep = d->irBuilder.CreateGEP(llvmTy, wrappedVal, gepIndices);
+	auto gep = d->irBuilder.CreateGEP(llvmMultiTy, wrappedVal, gepIndices);
 	auto castedPtr = d->irBuilder.CreateBitCast(gep, llvmTy->getPointerTo());
 	auto innerVal = d->irBuilder.CreateLoad(llvmTy, castedPtr);
 	return innerVal;
@@ -56,13 +56,20 @@
 
 namespace llvm {
 	class AllocaInst;
+	enum class AtomicOrdering : unsigned;
+	class Attribute;
+	class BasicBlock;
+	class BranchInst;
+	class Constant;
 	class Value;
 	class Function;
 	class FunctionType;
+	class LoadInst;
 	class Type;
 	class Module;
 	class raw_ostream;
 	class StructType;
+	class TargetMachine;
 }
 
 
@@ -115,6 +122,16 @@ namespace LIL
 		llvm::Value * _emitRuleInner(LILRule * value);
 		void _connectRule(LILRule * value, llvm::Value * parentId, llvm::Value * parentIndex, llvm::Value * thisObj);
 		llvm::Value* _getContainerNameFromSelectorChain(std::shared_ptr<LILSelectorChain> selCh);
+		void _connectRuleAtRuntime(LILRule * value, llvm::Function * ruleFn, LILSelectorChain * selCh, llvm::Value * parentId, llvm::Value * parentIndex, llvm::Value * thisObj, llvm::Function * applyFn);
+		void _emitStaticSelection(LILRule * value, llvm::Function * ruleFn, const std::vector<long int> & ids, llvm::Value * parentIndex);
+		void _emitDOMMatchesFlag();
+		bool _isDOMStatic();
+		bool _domHasMenusLast(LILElement * elem, long int & nextId, bool & sawMenu) const;
+		bool _ruleCreatesOnlyDOMElements(LILRule * rule, bool isTopLevel) const;
+		bool _runsCode(LILNode * node) const;
+		bool _resolveStaticSelection(LILSelectorChain * value, llvm::Value * parentIndex, std::vector<long int> & outIds);
+		LILElement * _findElementWithId(LILElement * elem, long int id) const;
+		void _emitRuleCallForId(LILRule * value, llvm::Function * ruleFn, llvm::Value * idValue, llvm::Value * indexValue, llvm::Value * parentIndex);
 		LILString _newRuleFnName();
 		llvm::Value * _emitSSel(LILSimpleSelector * value);
 		llvm::Value * _emitSelCh(LILSelectorChain * value, bool & outIsId, bool & outNeedsAlloca, llvm::Value* parentIndex, llvm::Value * thisObj);
@@ -126,23 +143,46 @@ namespace LIL
 		llvm::Function * _emitFnDecl(LILFunctionDecl * value);
 		llvm::Function * _emitFnSignature(std::string name, LILFunctionType * fnTy);
 		llvm::FunctionType * _emitLlvmFnType(LILFunctionType * fnTy);
+		llvm::Type * _llvmReturnTypeFromFnType(LILFunctionType * fnTy);
+		std::vector<llvm::Type *> _llvmArgTypesFromFnType(LILFunctionType * fnTy);
+		bool _isPassedIndirectly(llvm::Type * llvmTy) const;
+		bool _usesByValAttribute() const;
+		llvm::Type * _getAbiCoercedType(llvm::Type * llvmTy) const;
+		bool _flattenAbiAggregate(llvm::Type * llvmTy, uint64_t offset, std::vector<std::pair<uint64_t, llvm::Type *>> & scalars) const;
+		llvm::Value * _emitAbiCoercion(llvm::Value * value, llvm::Type * toTy);
+		std::vector<std::pair<unsigned, llvm::Attribute>> _getAbiAttributes(LILFunctionType * fnTy);
+		llvm::Value * _emitCallWithAbi(llvm::FunctionType * llvmFnTy, llvm::Value * fun, LILFunctionType * fnTy, const std::vector<llvm::Value *> & args, const LILString & name);
+		llvm::LoadInst * _getUnchangedLoad(llvm::Value * value) const;
+		void _emitStoreToVariable(llvm::Value * value, llvm::Value * storage);
+		bool _isUnescapedStorage(llvm::Value * storage) const;
 		llvm::Function * _emitFn( LILFunctionDecl * value);
 		llvm::Function * _emitFnBody(llvm::Function * fun, LILFunctionDecl * value);
 		void _emitDestructors(llvm::Value * ir, std::shared_ptr<LILClassDecl> cd, const LILString & name);
+		void _checkAllocasInEntryBlock(llvm::Function * fun, LILNode * value);
 		llvm::Value * _emitEvaluables(const std::vector<std::shared_ptr<LILNode>> & nodes);
 		llvm::Value * _emitFC(LILFunctionCall * value);
 		llvm::Value * _emitFCMultipleValues(std::vector<std::shared_ptr<LILFunctionDecl>> funcDecls, LILFunctionCall * value, llvm::Value * instance = nullptr, std::shared_ptr<LILType> instanceTy = nullptr);
+		llvm::Value * _emitFCMultipleValuesSwitch(const std::vector<std::shared_ptr<LILFunctionDecl>> & funcDecls, LILFunctionCall * value, llvm::Value * instance, const std::vector<std::shared_ptr<LILType>> & fcTypes, size_t i);
 		llvm::Value * _emitFunctionCall(LILFunctionCall * value, LILString name, LILFunctionType * fnTy, llvm::Value * instance, bool skipArgument = false, size_t skipArgIndex = 0);
 		llvm::Value * _emitFCArg(LILNode * value, LILType * ty);
 		llvm::Value * _emitFunctionCallMT(LILFunctionCall * value, LILString name, std::vector<std::shared_ptr<LILType>> types, LILFunctionType * fnTy, llvm::Value * instance);
 		llvm::Value * _emitFunctionCallPointer(llvm::Value * fun, LILFunctionCall * value, LILFunctionType * fnTy, llvm::Value * instance);
+		llvm::Value * _emitSIMDCall(LILFunctionCall * value);
+		llvm::Value * _emitSIMDScalar(llvm::Value * value, llvm::Type * elementTy);
+		llvm::Value * _emitSIMDAddress(LILNode * node, llvm::Type * vectorTy);
+		llvm::Value * _emitAtomicCall(LILFunctionCall * value);
+		llvm::Value * _emitAtomicOperand(LILNode * node, llvm::Type * valueTy);
+		llvm::AtomicOrdering _atomicOrderingForCall(LILFunctionCall * value) const;
 		llvm::Value * _emitFlowC(LILFlowControl * value);
 		llvm::Value * _emitIf(LILFlowControl * value);
 		llvm::Value * _emitIfCast(LILFlowControl * value);
 		llvm::Value * _emitIfCastConditionForNullable(bool negated, LILType * ty, LILNode * val);
 		llvm::Value * _emitIfCastConditionForMT(bool negated, LILType * ty, LILMultipleType * multiTy, LILNode * val);
 		llvm::Value * _emitFor(LILFlowControl * value);
+		llvm::Value * _emitForDataPointer(LILFlowControl * value);
+		llvm::Value * _emitParallelFor(LILFlowControl * value);
 		llvm::Value * _emitLoop(LILFlowControl * value);
+		void _emitLoopHints(LILFlowControl * value, llvm::BranchInst * latch, llvm::BasicBlock * loopBB);
 		llvm::Value * _emitFlowCCall(LILFlowControlCall * value);
 		llvm::Value * _emitReturn(LILFlowControlCall * value);
 		llvm::Value * _emitRepeat(LILFlowControlCall * value);
@@ -150,6 +190,7 @@ namespace LIL
 		llvm::Value * _emitInstr(LILInstruction * value);
 		llvm::Value * _emitForeignLang(LILForeignLang * value);
 		llvm::Value * _emitValList(LILValueList * value);
+		llvm::Constant * _emitConstantInitializer(LILNode * node, LILType * ty);
 		
 		void receiveLLVMIRData(llvm::LLVMIRParserEvent eventType, std::string data) override;
 
@@ -158,6 +199,8 @@ namespace LIL
 
 		void printIR(llvm::raw_ostream & file) const;
 		void setDebug(bool value);
+		void setLoopRemarks(bool value);
+		void setTargetMachine(llvm::TargetMachine * targetMachine);
 
 		llvm::StructType * extractStructFromClass(LILClassDecl * value);
 		size_t extractSizeFromNumberLiteral(LILNumberLiteral * value) const;
@@ -176,9 +219,13 @@ namespace LIL
 
 	private:
 		LILIREmitterPrivate *const d;
+		void _createFunctionPassManager(llvm::TargetMachine * targetMachine);
 		llvm::Type * llvmTypeFromLILType(LILType * type);
 		std::shared_ptr<LILFunctionDecl> chooseFnByType(std::vector<std::shared_ptr<LILFunctionDecl>> funcDecls, std::vector<std::shared_ptr<LILType>> types);
 		llvm::AllocaInst * createEntryBlockAlloca(llvm::Function * fun, const std::string & name, llvm::Type * llvmType);
+		llvm::AllocaInst * createTemporaryAlloca(llvm::Type * llvmType, const std::string & name = "");
+		void pushLifetimeScope();
+		void popLifetimeScope(bool emitEnd = true);
 		bool _isAnyPtrTy(LILType * ty) const;
 		void _convertLlvmValueIfNeeded(llvm::Value ** llvmValue, LILType * ty1, LILType * ty2);
 
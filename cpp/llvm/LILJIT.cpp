@@ -0,0 +1,291 @@
+/********************************************************************
+ *
+ *	  LIL Is a Language
+ *
+ *	  AUTHORS: Miro Keller
+ *
+ *	  COPYRIGHT: ©2020-today:  All Rights Reserved
+ *
+ *	  LICENSE: see LICENSE file
+ *
+ *	  This file runs the generated code in-process, using LLVM's ORC JIT
+ *
+ ********************************************************************/
+
+#include "LILJIT.h"
+
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace LIL;
+
+//the JIT orders the global constructors by priority alone, which shuffles the ones that
+//share a priority, but global variables need to be initialized in the order of their
+//declaration, so they are all called from a single constructor, as the linker would
+void LIL_mergeGlobalCtors(llvm::Module & module)
+{
+	auto ctors = module.getNamedGlobal("llvm.global_ctors");
+	if (!ctors || !ctors->hasInitializer()) {
+		return;
+	}
+	auto array = llvm::dyn_cast<llvm::ConstantArray>(ctors->getInitializer());
+	if (!array) {
+		return;
+	}
+	std::vector<std::pair<uint64_t, llvm::Function *>> fns;
+	for (auto & operand : array->operands()) {
+		auto entry = llvm::dyn_cast<llvm::ConstantStruct>(operand);
+		if (!entry) {
+			return;
+		}
+		auto priority = llvm::dyn_cast<llvm::ConstantInt>(entry->getOperand(0));
+		auto fn = llvm::dyn_cast<llvm::Function>(entry->getOperand(1)->stripPointerCasts());
+		if (!priority || !fn) {
+			return;
+		}
+		fns.push_back(std::make_pair(priority->getZExtValue(), fn));
+	}
+	std::stable_sort(fns.begin(), fns.end(), [](const auto & a, const auto & b) {
+		return a.first < b.first;
+	});
+
+	auto & context = module.getContext();
+	auto initFnTy = llvm::FunctionType::get(llvm::Type::getVoidTy(context), false);
+	auto initFn = llvm::Function::Create(initFnTy, llvm::GlobalValue::InternalLinkage, "LIL__jitGlobalCtors", module);
+	llvm::IRBuilder<> builder(llvm::BasicBlock::Create(context, "entry", initFn));
+	for (const auto & fn : fns) {
+		builder.CreateCall(fn.second);
+	}
+	builder.CreateRetVoid();
+
+	ctors->eraseFromParent();
+	llvm::appendToGlobalCtors(module, initFn, 0);
+}
+
+namespace LIL
+{
+	class LILJITPrivate
+	{
+		friend class LILJIT;
+
+		LILJITPrivate()
+		: jit(nullptr)
+		, verbose(false)
+		{
+		}
+		std::unique_ptr<llvm::orc::LLJIT> jit;
+		std::string targetTriple;
+		bool verbose;
+	};
+}
+
+LILJIT::LILJIT()
+: d(new LILJITPrivate())
+{
+	
+}
+
+LILJIT::~LILJIT()
+{
+	delete d;
+}
+
+bool LILJIT::initialize()
+{
+	llvm::InitializeNativeTarget();
+	llvm::InitializeNativeTargetAsmPrinter();
+
+	auto jitOrErr = llvm::orc::LLJITBuilder().create();
+	if (!jitOrErr) {
+		std::cerr << "Error: could not create the JIT: " << llvm::toString(jitOrErr.takeError()) << "\n";
+		return false;
+	}
+	d->jit = std::move(*jitOrErr);
+	d->targetTriple = d->jit->getTargetTriple().str();
+
+	//resolve extern C symbols (libc and friends) from the compiler process itself
+	auto generator = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(d->jit->getDataLayout().getGlobalPrefix());
+	if (!generator) {
+		std::cerr << "Error: could not resolve host symbols for the JIT: " << llvm::toString(generator.takeError()) << "\n";
+		return false;
+	}
+	d->jit->getMainJITDylib().addGenerator(std::move(*generator));
+	return true;
+}
+
+const llvm::DataLayout & LILJIT::getDataLayout() const
+{
+	return d->jit->getDataLayout();
+}
+
+const std::string & LILJIT::getTargetTriple() const
+{
+	return d->targetTriple;
+}
+
+bool LILJIT::addModule(std::unique_ptr<llvm::Module> module, std::unique_ptr<llvm::LLVMContext> context)
+{
+	if (!d->jit) {
+		std::cerr << "Error: the JIT was not initialized.\n";
+		return false;
+	}
+	LIL_mergeGlobalCtors(*module);
+	auto err = d->jit->addIRModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(context)));
+	if (err) {
+		std::cerr << "Error: could not add module to the JIT: " << llvm::toString(std::move(err)) << "\n";
+		return false;
+	}
+	return true;
+}
+
+bool LILJIT::addObjectFile(const std::string & path)
+{
+	if (!d->jit) {
+		std::cerr << "Error: the JIT was not initialized.\n";
+		return false;
+	}
+	auto buffer = llvm::MemoryBuffer::getFile(path);
+	if (!buffer) {
+		std::cerr << "Error: could not read the object file " << path << ": " << buffer.getError().message() << "\n";
+		return false;
+	}
+	auto err = d->jit->addObjectFile(std::move(*buffer));
+	if (err) {
+		std::cerr << "Error: could not add the object file " << path << " to the JIT: " << llvm::toString(std::move(err)) << "\n";
+		return false;
+	}
+	return true;
+}
+
+bool LILJIT::addArchive(const std::string & path)
+{
+	if (!d->jit) {
+		std::cerr << "Error: the JIT was not initialized.\n";
+		return false;
+	}
+	//members of the archive are only loaded when one of their symbols is looked up
+	auto generator = llvm::orc::StaticLibraryDefinitionGenerator::Load(d->jit->getObjLinkingLayer(), path.c_str());
+	if (!generator) {
+		std::cerr << "Error: could not load the archive " << path << ": " << llvm::toString(generator.takeError()) << "\n";
+		return false;
+	}
+	d->jit->getMainJITDylib().addGenerator(std::move(*generator));
+	return true;
+}
+
+bool LILJIT::addDynamicLibrary(const std::string & path)
+{
+	if (!d->jit) {
+		std::cerr << "Error: the JIT was not initialized.\n";
+		return false;
+	}
+	auto generator = llvm::orc::DynamicLibrarySearchGenerator::Load(path.c_str(), d->jit->getDataLayout().getGlobalPrefix());
+	if (!generator) {
+		std::cerr << "Error: could not load the library " << path << ": " << llvm::toString(generator.takeError()) << "\n";
+		return false;
+	}
+	d->jit->getMainJITDylib().addGenerator(std::move(*generator));
+	return true;
+}
+
+int LILJIT::runMain(const std::vector<std::string> & args)
+{
+	if (!d->jit) {
+		std::cerr << "Error: the JIT was not initialized.\n";
+		return -1;
+	}
+#if defined(_WIN32)
+	return this->_runMainInProcess(args);
+#else
+	//the program runs in a child process, so that calling exit() or crashing doesn't take the
+	//compiler down with it, which matters when it is serving requests. The child inherits the
+	//file descriptors, so its output goes to the same place as the compiler's
+	std::cout.flush();
+	std::cerr.flush();
+	fflush(stdout);
+	fflush(stderr);
+	pid_t pid = fork();
+	if (pid < 0) {
+		std::cerr << "Error: could not start a process to run the program in.\n";
+		return -1;
+	}
+	if (pid == 0) {
+		int ret = this->_runMainInProcess(args);
+		std::cerr.flush();
+		fflush(stderr);
+		//skip the compiler's own exit handlers and static destructors
+		_exit(ret);
+	}
+	int status = 0;
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR) {
+			std::cerr << "Error: could not wait for the program to finish.\n";
+			return -1;
+		}
+	}
+	if (WIFSIGNALED(status)) {
+		int signalNumber = WTERMSIG(status);
+		std::cerr << "Error: the program was terminated by signal " << signalNumber << " (" << strsignal(signalNumber) << ").\n";
+		return 128 + signalNumber;
+	}
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+}
+
+int LILJIT::_runMainInProcess(const std::vector<std::string> & args)
+{
+	auto & mainDylib = d->jit->getMainJITDylib();
+	//run the global constructors, which is where global variables get initialized
+	if (auto err = d->jit->initialize(mainDylib)) {
+		std::cerr << "Error: could not run the initializers: " << llvm::toString(std::move(err)) << "\n";
+		return -1;
+	}
+	auto mainSym = d->jit->lookup("main");
+	if (!mainSym) {
+		std::cerr << "Error: could not find the main function: " << llvm::toString(mainSym.takeError()) << "\n";
+		return -1;
+	}
+	
+	std::vector<char *> argv;
+	for (const auto & arg : args) {
+		argv.push_back(const_cast<char *>(arg.c_str()));
+	}
+	argv.push_back(nullptr);
+
+	if (d->verbose) {
+		std::cerr << "Calling main() in the JIT\n\n";
+	}
+	auto mainFn = llvm::jitTargetAddressToFunction<int(*)(int, char **)>(mainSym->getAddress());
+	int ret = mainFn(static_cast<int>(args.size()), argv.data());
+	std::cout.flush();
+	fflush(stdout);
+
+	if (auto err = d->jit->deinitialize(mainDylib)) {
+		std::cerr << "Error: could not run the deinitializers: " << llvm::toString(std::move(err)) << "\n";
+	}
+	return ret;
+}
+
+void LILJIT::setVerbose(bool value)
+{
+	d->verbose = value;
+}
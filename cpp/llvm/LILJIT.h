@@ -0,0 +1,54 @@
+/********************************************************************
+ *
+ *	  LIL Is a Language
+ *
+ *	  AUTHORS: Miro Keller
+ *
+ *	  COPYRIGHT: ©2020-today:  All Rights Reserved
+ *
+ *	  LICENSE: see LICENSE file
+ *
+ *	  This file runs the generated code in-process, using LLVM's ORC JIT
+ *
+ ********************************************************************/
+
+#ifndef LILJIT_H
+#define LILJIT_H
+
+#include "LILShared.h"
+
+namespace llvm
+{
+	class DataLayout;
+	class LLVMContext;
+	class Module;
+}
+
+namespace LIL
+{
+	class LILJITPrivate;
+	class LILJIT
+	{
+	public:
+		LILJIT();
+		virtual ~LILJIT();
+
+		bool initialize();
+		const llvm::DataLayout & getDataLayout() const;
+		const std::string & getTargetTriple() const;
+
+		bool addModule(std::unique_ptr<llvm::Module> module, std::unique_ptr<llvm::LLVMContext> context);
+		bool addObjectFile(const std::string & path);
+		bool addArchive(const std::string & path);
+		bool addDynamicLibrary(const std::string & path);
+		int runMain(const std::vector<std::string> & args);
+
+		void setVerbose(bool value);
+
+	private:
+		LILJITPrivate * d;
+		int _runMainInProcess(const std::vector<std::string> & args);
+	};
+}
+
+#endif
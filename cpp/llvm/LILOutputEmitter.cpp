@@ -17,9 +17,14 @@
 #include "LILOutputEmitter.h"
 #include "LILRootNode.h"
 #include "LILIREmitter.h"
+#include "LILJIT.h"
 
 #include "../shared/LILDOMBuilder.h"
 
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Type.h"
@@ -34,6 +39,7 @@
 
 using namespace LIL;
 
+extern void LILPrintErrors(const std::vector<LILErrorMessage> & errors, const LILString & code);
 
 namespace LIL
 {
@@ -46,6 +52,8 @@ namespace LIL
 		, targetMachine(nullptr)
 		, verbose(false)
 		, debugIREmitter(false)
+		, codegenThreads(1)
+		, loopRemarks(false)
 		{
 		}
 		LILString inFile;
@@ -54,12 +62,17 @@ namespace LIL
 		LILString source;
 		LILString cpu;
 		LILString vendor;
+		//when set, overrides the triple made from cpu and vendor
+		std::string targetTriple;
 
 		LILIREmitter * irEmitter;
 		llvm::TargetMachine * targetMachine;
 		
 		bool verbose;
 		bool debugIREmitter;
+		unsigned codegenThreads;
+		bool loopRemarks;
+		std::vector<std::string> outputFiles;
 	};
 }
 
@@ -81,6 +94,7 @@ LILOutputEmitter::~LILOutputEmitter()
 void LILOutputEmitter::prepare()
 {
 	d->irEmitter = new LILIREmitter(this->getInFile());
+	d->irEmitter->setLoopRemarks(d->loopRemarks);
 }
 
 llvm::Module * LILOutputEmitter::getLLVMModule() const
@@ -88,58 +102,115 @@ llvm::Module * LILOutputEmitter::getLLVMModule() const
 	return d->irEmitter->getLLVMModule();
 }
 
-void LILOutputEmitter::run(std::shared_ptr<LILRootNode> rootNode)
+//the partitions of a split module are written next to the main object file,
+//e.g. main.o, main.part1.o, main.part2.o
+std::string LIL_getPartitionPath(const std::string & outPath, unsigned index)
 {
-	std::error_code error_code;
-	
-	std::string targetTriple;
-	const std::string & cpuString = this->getCPU().data();
-	const std::string & vendorString = this->getVendor().data();
+	size_t dotIndex = outPath.find_last_of(".");
+	size_t slashIndex = outPath.find_last_of("/");
+	if (dotIndex == std::string::npos || (slashIndex != std::string::npos && dotIndex < slashIndex)) {
+		return outPath + ".part" + std::to_string(index);
+	}
+	return outPath.substr(0, dotIndex) + ".part" + std::to_string(index) + outPath.substr(dotIndex);
+}
 
-	if (cpuString.length() == 0 || vendorString.length() == 0) {
-		std::cerr << "Error: Unknown CPU or vendor: " << cpuString << "/" << vendorString << ".\n";
-		targetTriple = llvm::sys::getDefaultTargetTriple();
-	} else {
-		targetTriple = cpuString + "-" + vendorString;
+//partitions left over from a previous build with more threads would end up in the link twice
+void LIL_removeStalePartitions(const std::string & outPath, unsigned firstStale)
+{
+	for (unsigned i = firstStale; ; ++i) {
+		std::string partPath = LIL_getPartitionPath(outPath, i);
+		if (!llvm::sys::fs::exists(partPath)) {
+			break;
+		}
+		llvm::sys::fs::remove(partPath);
 	}
+}
 
-	LLVMInitializeX86TargetInfo();
-	LLVMInitializeX86Target();
-	LLVMInitializeX86TargetMC();
-	LLVMInitializeX86AsmPrinter();
+//targets are initialized and target machines created only once per process,
+//since every code unit of a build (and every build, in server mode) uses the same ones
+//no lock is needed: the server handles one request at a time and the split codegen
+//threads create their own target machines instead of calling this
+llvm::TargetMachine * LIL_getTargetMachine(const std::string & targetTriple)
+{
+	static bool targetsInitialized = false;
+	static std::map<std::string, llvm::TargetMachine *> targetMachines;
+
+	if (!targetsInitialized) {
+		LLVMInitializeX86TargetInfo();
+		LLVMInitializeX86Target();
+		LLVMInitializeX86TargetMC();
+		LLVMInitializeX86AsmPrinter();
+
+		LLVMInitializeARMTargetInfo();
+		LLVMInitializeARMTarget();
+		LLVMInitializeARMTargetMC();
+		LLVMInitializeARMAsmPrinter();
+		
+		LLVMInitializeAArch64TargetInfo();
+		LLVMInitializeAArch64Target();
+		LLVMInitializeAArch64TargetMC();
+		LLVMInitializeAArch64AsmPrinter();
+		targetsInitialized = true;
+	}
 
-	LLVMInitializeARMTargetInfo();
-	LLVMInitializeARMTarget();
-	LLVMInitializeARMTargetMC();
-	LLVMInitializeARMAsmPrinter();
-	
-	LLVMInitializeAArch64TargetInfo();
-	LLVMInitializeAArch64Target();
-	LLVMInitializeAArch64TargetMC();
-	LLVMInitializeAArch64AsmPrinter();
+	auto it = targetMachines.find(targetTriple);
+	if (it != targetMachines.end()) {
+		return it->second;
+	}
 
 	std::string error;
 	auto target = llvm::TargetRegistry::lookupTarget(targetTriple, error);
 	if (!target) {
 		std::cerr << "Error: could not look up target: " << targetTriple << "\n";
-		return;
+		return nullptr;
 	}
 
 	auto cpu = "generic";
 	auto features = "";
 	llvm::TargetOptions opt;
+	//one section per function and global, so that the linker can drop the ones the
+	//program never reaches (mach-o objects are split at every symbol already)
+	opt.FunctionSections = true;
+	opt.DataSections = true;
 	auto relocModel = llvm::Optional<llvm::Reloc::Model>();
-	d->targetMachine = target->createTargetMachine(targetTriple, cpu, features, opt, relocModel);
+	auto targetMachine = target->createTargetMachine(targetTriple, cpu, features, opt, relocModel);
+	targetMachines[targetTriple] = targetMachine;
+	return targetMachine;
+}
+
+void LILOutputEmitter::run(std::shared_ptr<LILRootNode> rootNode)
+{
+	std::error_code error_code;
+	
+	std::string targetTriple;
+	const std::string & cpuString = this->getCPU().data();
+	const std::string & vendorString = this->getVendor().data();
+
+	if (d->targetTriple.length() > 0) {
+		targetTriple = d->targetTriple;
+	} else if (cpuString.length() == 0 || vendorString.length() == 0) {
+		std::cerr << "Error: Unknown CPU or vendor: " << cpuString << "/" << vendorString << ".\n";
+		targetTriple = llvm::sys::getDefaultTargetTriple();
+	} else {
+		targetTriple = cpuString + "-" + vendorString;
+	}
+
+	d->targetMachine = LIL_getTargetMachine(targetTriple);
+	if (!d->targetMachine) {
+		return;
+	}
 	
 	llvm::Module * theModule = d->irEmitter->getLLVMModule();
 	theModule->setDataLayout(d->targetMachine->createDataLayout());
 	theModule->setTargetTriple(targetTriple);
+	d->irEmitter->setTargetMachine(d->targetMachine);
 	
 	//emit IR
 	d->irEmitter->setVerbose(d->verbose);
 	d->irEmitter->initializeVisit();
 	d->irEmitter->performVisit(rootNode);
 	if (d->irEmitter->hasErrors()) {
+		LILPrintErrors(d->irEmitter->errors, "");
 		std::cerr << "Errors encountered. Exiting.\n";
 		return;
 	}
@@ -166,6 +237,54 @@ void LILOutputEmitter::compileToO(std::shared_ptr<LILRootNode> rootNode)
 		d->irEmitter->printIR(llvm::errs());
 	}
 	
+	llvm::Module * theModule = d->irEmitter->getLLVMModule();
+	std::string outPath = this->getDir().data() + "/" + this->getOutFile().data();
+	d->outputFiles.clear();
+	d->outputFiles.push_back(outPath);
+
+	if (d->codegenThreads > 1) {
+		//split the module into partitions which are code generated in parallel,
+		//each on its own thread with its own context and target machine
+		std::vector<std::unique_ptr<llvm::raw_fd_ostream>> partStreams;
+		std::vector<llvm::raw_pwrite_stream *> partStreamPtrs;
+		partStreamPtrs.push_back(&dest);
+		for (unsigned i = 1; i < d->codegenThreads; ++i) {
+			std::string partPath = LIL_getPartitionPath(outPath, i);
+			auto partStream = std::make_unique<llvm::raw_fd_ostream>(partPath, error_code, llvm::sys::fs::OF_None);
+			if (error_code) {
+				std::cerr << "Error: could not open destination file " << partPath << ".\n";
+				return;
+			}
+			partStreamPtrs.push_back(partStream.get());
+			partStreams.push_back(std::move(partStream));
+			d->outputFiles.push_back(partPath);
+		}
+		LIL_removeStalePartitions(outPath, d->codegenThreads);
+
+		//every partition is compiled exactly like the unsplit module would be
+		llvm::TargetMachine * mainTM = d->targetMachine;
+		const llvm::Target & target = mainTM->getTarget();
+		std::string targetTriple = mainTM->getTargetTriple().str();
+		std::string cpu = mainTM->getTargetCPU().str();
+		std::string features = mainTM->getTargetFeatureString().str();
+		llvm::TargetOptions opt = mainTM->Options;
+		llvm::Reloc::Model relocModel = mainTM->getRelocationModel();
+		llvm::CodeModel::Model codeModel = mainTM->getCodeModel();
+		llvm::CodeGenOpt::Level optLevel = mainTM->getOptLevel();
+		//private globals stay private in their partition, otherwise they get
+		//externalized under the same name in every object and collide when linking
+		llvm::splitCodeGen(*theModule, partStreamPtrs, {}, [&target, targetTriple, cpu, features, opt, relocModel, codeModel, optLevel]() {
+			return std::unique_ptr<llvm::TargetMachine>(target.createTargetMachine(targetTriple, cpu, features, opt, relocModel, codeModel, optLevel));
+		}, llvm::CGFT_ObjectFile, /*PreserveLocals=*/true);
+
+		for (auto & partStream : partStreams) {
+			partStream->flush();
+		}
+		dest.flush();
+		return;
+	}
+	LIL_removeStalePartitions(outPath, 1);
+
 	llvm::legacy::PassManager emitPassMngr;
 	auto fileType = llvm::CGFT_ObjectFile;
 	
@@ -173,12 +292,29 @@ void LILOutputEmitter::compileToO(std::shared_ptr<LILRootNode> rootNode)
 		std::cerr << "Error: could not create file type for emitting code.\n";
 		return;
 	}
-	llvm::Module * theModule = d->irEmitter->getLLVMModule();
 	emitPassMngr.run(*theModule);
 	
 	dest.flush();
 }
 
+const std::vector<std::string> & LILOutputEmitter::getOutputFiles() const
+{
+	return d->outputFiles;
+}
+
+std::vector<std::string> LILOutputEmitter::getExistingPartitions(const std::string & outPath)
+{
+	std::vector<std::string> ret;
+	for (unsigned i = 1; ; ++i) {
+		std::string partPath = LIL_getPartitionPath(outPath, i);
+		if (!llvm::sys::fs::exists(partPath)) {
+			break;
+		}
+		ret.push_back(partPath);
+	}
+	return ret;
+}
+
 void LILOutputEmitter::compileToS(std::shared_ptr<LILRootNode> rootNode)
 {
 	std::error_code error_code;
@@ -197,6 +333,37 @@ void LILOutputEmitter::compileToS(std::shared_ptr<LILRootNode> rootNode)
 	dest.flush();
 }
 
+bool LILOutputEmitter::compileToJIT(std::shared_ptr<LILRootNode> rootNode, LILJIT * jit)
+{
+	//emit for the host, so that the functions go through the same optimization passes,
+	//with the same cost model and data layout, as an object file built for it would
+	d->targetTriple = jit->getTargetTriple();
+	this->run(rootNode);
+	if (d->irEmitter->hasErrors() || !d->targetMachine) {
+		return false;
+	}
+
+	llvm::Module * theModule = d->irEmitter->getLLVMModule();
+
+	if (d->verbose) {
+		d->irEmitter->printIR(llvm::errs());
+	}
+
+	//the module lives inside the IR emitter's context, so hand the JIT
+	//its own copy, which it can own together with a fresh context
+	llvm::SmallVector<char, 0> bitcode;
+	llvm::raw_svector_ostream bitcodeStream(bitcode);
+	llvm::WriteBitcodeToFile(*theModule, bitcodeStream);
+
+	auto context = std::make_unique<llvm::LLVMContext>();
+	auto moduleOrErr = llvm::parseBitcodeFile(llvm::MemoryBufferRef(llvm::StringRef(bitcode.data(), bitcode.size()), theModule->getName()), *context);
+	if (!moduleOrErr) {
+		std::cerr << "Error: could not copy the module for the JIT: " << llvm::toString(moduleOrErr.takeError()) << "\n";
+		return false;
+	}
+	return jit->addModule(std::move(*moduleOrErr), std::move(context));
+}
+
 void LILOutputEmitter::printToOutput(std::shared_ptr<LILRootNode> rootNode)
 {
 	this->run(rootNode);
@@ -217,6 +384,8 @@ void LILOutputEmitter::printToOutput(std::shared_ptr<LILRootNode> rootNode)
 		} else {
 			d->irEmitter->printIR(llvm::outs());
 		}
+		//llvm::outs() is buffered, in server mode the process doesn't exit after the build
+		llvm::outs().flush();
 	}
 }
 
@@ -230,6 +399,16 @@ void LILOutputEmitter::setDebugIREmitter(bool value)
 	d->debugIREmitter = value;
 }
 
+void LILOutputEmitter::setCodegenThreads(unsigned value)
+{
+	d->codegenThreads = value;
+}
+
+void LILOutputEmitter::setLoopRemarks(bool value)
+{
+	d->loopRemarks = value;
+}
+
 void LILOutputEmitter::setInFile(const LILString & file)
 {
 	d->inFile = file;
@@ -25,6 +25,7 @@ namespace llvm
 namespace LIL
 {
 	class LILElement;
+	class LILJIT;
 	class LILRootNode;
 	class LILOutputEmitterPrivate;
 	class LILOutputEmitter
@@ -54,9 +55,14 @@ namespace LIL
 		void run(std::shared_ptr<LILRootNode> rootNode);
 		void compileToO(std::shared_ptr<LILRootNode> rootNode);
 		void compileToS(std::shared_ptr<LILRootNode> rootNode);
+		bool compileToJIT(std::shared_ptr<LILRootNode> rootNode, LILJIT * jit);
 		void printToOutput(std::shared_ptr<LILRootNode> rootNode);
 		void setVerbose(bool value);
 		void setDebugIREmitter(bool value);
+		void setCodegenThreads(unsigned value);
+		void setLoopRemarks(bool value);
+		const std::vector<std::string> & getOutputFiles() const;
+		static std::vector<std::string> getExistingPartitions(const std::string & outPath);
 		
 	private:
 		LILOutputEmitterPrivate * d;
@@ -3845,6 +3845,10 @@ bool LILCodeParser::readInstruction()
 		{
 			return this->readInstrSimple();
 		}
+		else if (currentval == "unroll" || currentval == "vectorize" || currentval == "noalias" || currentval == "independent" || currentval == "parallel")
+		{
+			return this->readLoopHintInstr();
+		}
 		else
 		{
 			d->receiver->receiveError("Error: unknown instruction type "+currentval, d->file, d->line, d->column);
@@ -4444,6 +4448,52 @@ bool LILCodeParser::readGPUInstr()
 	LIL_END_NODE
 }
 
+//#unroll, #unroll(4), #vectorize(8), #noalias or #parallel, followed by the loop they apply to
+bool LILCodeParser::readLoopHintInstr()
+{
+	LIL_START_NODE(NodeTypeInstruction)
+
+	//skip the instruction sign
+	d->receiver->receiveNodeData(ParserEventInstruction, d->currentToken->getString());
+	this->readNextToken();
+	if (atEndOfSource())
+		return false;
+
+	d->receiver->receiveNodeData(ParserEventInstruction, d->currentToken->getString());
+
+	this->readNextToken();
+	LIL_CHECK_FOR_END_AND_SKIP_WHITESPACE
+
+	//optional count
+	if (d->currentToken->isA(TokenTypeParenthesisOpen)){
+		d->receiver->receiveNodeData(ParserEventPunctuation, d->currentToken->getString());
+		this->readNextToken();
+		LIL_CHECK_FOR_END_AND_SKIP_WHITESPACE
+
+		bool outIsSV = false;
+		NodeType svExpTy = NodeTypeInvalid;
+		bool argValid = this->readExpression(outIsSV, svExpTy);
+		if (argValid)
+		{
+			d->receiver->receiveNodeCommit();
+		}
+		else
+		{
+			LIL_CANCEL_NODE
+		}
+
+		LIL_EXPECT(TokenTypeParenthesisClose, "closing parenthesis")
+		d->receiver->receiveNodeData(ParserEventPunctuation, d->currentToken->getString());
+		this->readNextToken();
+		LIL_CHECK_FOR_END_AND_SKIP_WHITESPACE
+	}
+
+	//the loop
+	this->parseNext();
+
+	LIL_END_NODE
+}
+
 bool LILCodeParser::readValuePath(bool allowFunctionCall)
 {
 	bool done = false;
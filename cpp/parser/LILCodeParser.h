@@ -126,6 +126,7 @@ namespace LIL
 		bool readArgInstr();
 		bool readInstrSimple();
 		bool readGPUInstr();
+		bool readLoopHintInstr();
 		bool readValuePath(bool allowFunctionCall);
 		bool readVarName();
 		bool readPropertyName();
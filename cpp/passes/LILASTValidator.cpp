@@ -776,6 +776,104 @@ void LILASTValidator::_validate(const std::shared_ptr<LILFunctionDecl> & value)
 		const auto & eval = evals[i];
 		this->_validateFunctionDeclChild(value.get(), eval.get());
 	}
+	this->_validateParallelFors(value.get());
+}
+
+void LILASTValidator::_validateParallelFors(LILNode * node)
+{
+	for (const auto & childNode : node->getChildNodes()) {
+		if (childNode->isA(NodeTypeFlowControl)) {
+			auto fc = std::static_pointer_cast<LILFlowControl>(childNode);
+			if (fc->getIsParallel()) {
+				this->_validateParallelCounter(fc.get());
+				for (const auto & thenNode : fc->getThen()) {
+					this->_validateParallelBody(thenNode.get(), false);
+				}
+			}
+		}
+		this->_validateParallelFors(childNode.get());
+	}
+}
+
+//only counted loops can be split into ranges, (var.i64 i: start; i < end; i +: 1) or for n
+void LILASTValidator::_validateParallelCounter(LILFlowControl * fc)
+{
+	const auto & arguments = fc->getArguments();
+	bool isCounted = false;
+	bool isInteger = true;
+	if (arguments.size() == 1) {
+		isCounted = true;
+		auto arg = arguments[0];
+		if (arg->isA(NodeTypeNumberLiteral)) {
+			isInteger = std::static_pointer_cast<LILNumberLiteral>(arg)->getValue().data().find('.') == std::string::npos;
+		}
+	} else if (
+		arguments.size() == 3
+		&& arguments[0]->isA(NodeTypeVarDecl)
+		&& arguments[1]->isA(NodeTypeExpression)
+		&& arguments[2]->isA(NodeTypeUnaryExpression)
+	) {
+		auto counterVd = std::static_pointer_cast<LILVarDecl>(arguments[0]);
+		auto comparison = std::static_pointer_cast<LILExpression>(arguments[1]);
+		auto step = std::static_pointer_cast<LILUnaryExpression>(arguments[2]);
+		auto left = comparison->getLeft();
+		auto stepSubject = step->getSubject();
+		auto stepValue = step->getValue();
+		isCounted = counterVd->getInitVal()
+			&& comparison->getExpressionType() == ExpressionTypeSmallerComparison
+			&& left && left->isA(NodeTypeVarName)
+			&& std::static_pointer_cast<LILVarName>(left)->getName() == counterVd->getName()
+			&& step->getUnaryExpressionType() == UnaryExpressionTypeSum
+			&& stepSubject && stepSubject->isA(NodeTypeVarName)
+			&& std::static_pointer_cast<LILVarName>(stepSubject)->getName() == counterVd->getName()
+			&& stepValue && stepValue->isA(NodeTypeNumberLiteral)
+			&& std::static_pointer_cast<LILNumberLiteral>(stepValue)->getValue().toLongLong() == 1;
+		auto counterTy = counterVd->getType();
+		if (counterTy) {
+			isInteger = LILType::isIntegerType(counterTy.get());
+		} else if (isCounted && counterVd->getInitVal()->isA(NodeTypeNumberLiteral)) {
+			isInteger = std::static_pointer_cast<LILNumberLiteral>(counterVd->getInitVal())->getValue().data().find('.') == std::string::npos;
+		}
+	}
+	if (!isCounted || !isInteger) {
+		LILErrorMessage ei;
+		if (!isCounted) {
+			ei.message =  "A #parallel for needs a counted loop, like (var.i64 i: 0; i < count; i +: 1)";
+		} else {
+			ei.message =  "The counter of a #parallel for needs to be an integer";
+		}
+		LILNode::SourceLocation sl = fc->getSourceLocation();
+		ei.file = sl.file;
+		ei.line = sl.line;
+		ei.column = sl.column;
+		this->errors.push_back(ei);
+	}
+}
+
+//the body of a #parallel for runs as its own function on several threads at once,
+//so it can't return from the enclosing function or break out of the loop
+void LILASTValidator::_validateParallelBody(LILNode * node, bool isInsideLoop)
+{
+	if (node->isA(NodeTypeFlowControlCall)) {
+		auto fcc = static_cast<LILFlowControlCall *>(node);
+		auto fccType = fcc->getFlowControlCallType();
+		if (
+			fccType == FlowControlCallTypeReturn
+			|| (!isInsideLoop && (fccType == FlowControlCallTypeBreak || fccType == FlowControlCallTypeRepeat))
+		) {
+			LILErrorMessage ei;
+			ei.message =  "The body of a #parallel for can't contain " + LILNodeToString::stringify(node);
+			LILNode::SourceLocation sl = node->getSourceLocation();
+			ei.file = sl.file;
+			ei.line = sl.line;
+			ei.column = sl.column;
+			this->errors.push_back(ei);
+		}
+	}
+	bool childIsInsideLoop = isInsideLoop || node->getFlowControlType() == FlowControlTypeFor || node->getFlowControlType() == FlowControlTypeLoop;
+	for (const auto & childNode : node->getChildNodes()) {
+		this->_validateParallelBody(childNode.get(), childIsInsideLoop);
+	}
 }
 
 void LILASTValidator::_validateFunctionDeclChild(LILFunctionDecl * value, LILNode *node)
@@ -801,6 +899,14 @@ void LILASTValidator::_validateFunctionDeclChild(LILFunctionDecl * value, LILNod
 				{
 					break;
 				}
+				case InstructionTypeUnroll:
+				case InstructionTypeVectorize:
+				case InstructionTypeIndependent:
+				case InstructionTypeParallel:
+				{
+					this->_validate(std::static_pointer_cast<LILInstruction>(node->shared_from_this()));
+					return;
+				}
 				default:
 					this->illegalNodeType(node, value);
 					return;
@@ -882,6 +988,108 @@ void LILASTValidator::_validate(const std::shared_ptr<LILFunctionCall> & value)
 			}
 			break;
 		}
+		case FunctionCallTypeSIMD:
+		{
+			const auto & name = value->getName();
+			size_t argCount = value->getArguments().size();
+			size_t expected = 2;
+			if (name == "simdSqrt" || name == "simdAbs" || name == "simdReduceAdd" || name == "simdReduceMin" || name == "simdReduceMax") {
+				expected = 1;
+			} else if (name == "simdWithLane" || name == "simdSelect" || name == "simdFma") {
+				expected = 3;
+			}
+			bool valid = argCount == expected;
+			//a shuffle takes two vectors and at least one lane index
+			if (name == "simdShuffle") {
+				valid = argCount > 2;
+			}
+			if (!valid) {
+				LILErrorMessage ei;
+				ei.message =  "Wrong number of arguments in call to " + name + "()";
+				LILNode::SourceLocation sl = value->getSourceLocation();
+				ei.file = sl.file;
+				ei.line = sl.line;
+				ei.column = sl.column;
+				this->errors.push_back(ei);
+				break;
+			}
+			//the lanes become the constant mask of the shuffle, the type validator checks their range
+			if (name == "simdShuffle") {
+				const auto & args = value->getArguments();
+				for (size_t i=2, j=args.size(); i<j; ++i) {
+					const auto & laneNode = args[i];
+					bool isLane = false;
+					if (laneNode->isA(NodeTypeNumberLiteral)) {
+						const auto & laneStr = std::static_pointer_cast<LILNumberLiteral>(laneNode)->getValue();
+						isLane = laneStr.data().find_first_of(".-") == std::string::npos;
+					}
+					if (!isLane) {
+						LILErrorMessage ei;
+						ei.message =  "The lanes in call to simdShuffle() must be whole number literals, not negative";
+						LILNode::SourceLocation sl = laneNode->getSourceLocation();
+						ei.file = sl.file;
+						ei.line = sl.line;
+						ei.column = sl.column;
+						this->errors.push_back(ei);
+					}
+				}
+			}
+			break;
+		}
+		case FunctionCallTypeAtomic:
+		{
+			const auto & name = value->getName();
+			const auto & args = value->getArguments();
+			size_t expected = LILFunctionCall::atomicArgumentCount(name);
+			if (args.size() != expected && args.size() != expected + 1) {
+				LILErrorMessage ei;
+				ei.message =  "Wrong number of arguments in call to " + name + "()";
+				LILNode::SourceLocation sl = value->getSourceLocation();
+				ei.file = sl.file;
+				ei.line = sl.line;
+				ei.column = sl.column;
+				this->errors.push_back(ei);
+				break;
+			}
+			if (args.size() == expected + 1) {
+				const auto & orderNode = args.back();
+				bool validOrder = false;
+				if (orderNode->isA(NodeTypeStringLiteral)) {
+					auto orderStr = std::static_pointer_cast<LILStringLiteral>(orderNode)->getValue().stripQuotes();
+					validOrder = LILFunctionCall::isAtomicOrdering(orderStr);
+				}
+				if (!validOrder) {
+					LILErrorMessage ei;
+					ei.message =  "The ordering in call to " + name + "() must be one of `relaxed`, `acquire`, `release`, `acq_rel` or `seq_cst`";
+					LILNode::SourceLocation sl = orderNode->getSourceLocation();
+					ei.file = sl.file;
+					ei.line = sl.line;
+					ei.column = sl.column;
+					this->errors.push_back(ei);
+					break;
+				}
+				//orderings that LLVM doesn't allow for the kind of access
+				auto orderStr = std::static_pointer_cast<LILStringLiteral>(orderNode)->getValue().stripQuotes();
+				LILString orderError;
+				if (name == "atomicFence" && orderStr == "relaxed") {
+					orderError = "A fence can't be `relaxed`, since it would do nothing";
+				} else if (name == "atomicLoad" && (orderStr == "release" || orderStr == "acq_rel")) {
+					orderError = "An atomicLoad() can't have `release` or `acq_rel` ordering";
+				} else if (name == "atomicStore" && (orderStr == "acquire" || orderStr == "acq_rel")) {
+					orderError = "An atomicStore() can't have `acquire` or `acq_rel` ordering";
+				}
+				if (orderError.length() > 0) {
+					LILErrorMessage ei;
+					ei.message = orderError;
+					LILNode::SourceLocation sl = orderNode->getSourceLocation();
+					ei.file = sl.file;
+					ei.line = sl.line;
+					ei.column = sl.column;
+					this->errors.push_back(ei);
+				}
+			}
+			break;
+		}
 		default:
 			break;
 	}
@@ -923,6 +1131,24 @@ void LILASTValidator::_validate(const std::shared_ptr<LILFlowControlCall> & valu
 
 void LILASTValidator::_validate(const std::shared_ptr<LILInstruction> & value)
 {
+	//the AST builder moves valid loop hints into their loop
+	if (value->isLoopHint()) {
+		LILErrorMessage ei;
+		ei.message =  "The loop hint #" + LILInstruction::instructionTypeToString(value->getInstructionType()) + " needs to be followed by a for or loop statement";
+		if (value->isA(InstructionTypeParallel)) {
+			ei.message = "The loop hint #parallel needs to be followed by a for statement and takes no count";
+		} else if (value->isA(InstructionTypeIndependent)) {
+			ei.message += " and takes no count";
+		} else {
+			ei.message += " and its count needs to be a positive number literal";
+		}
+		LILNode::SourceLocation sl = value->getSourceLocation();
+		ei.file = sl.file;
+		ei.line = sl.line;
+		ei.column = sl.column;
+		this->errors.push_back(ei);
+		return;
+	}
 	if (this->getDebug()) {
 		std::cerr << "Nothing to do. OK\n";
 	}
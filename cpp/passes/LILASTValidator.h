@@ -100,6 +100,9 @@ namespace LIL
 		void _validate(const std::shared_ptr<LILFlag> & value);
 		void _validate(const std::shared_ptr<LILFunctionDecl> & value);
 		void _validateFunctionDeclChild(LILFunctionDecl * value, LILNode *node);
+		void _validateParallelFors(LILNode * node);
+		void _validateParallelCounter(LILFlowControl * fc);
+		void _validateParallelBody(LILNode * node, bool isInsideLoop);
 		void _validate(const std::shared_ptr<LILFunctionCall> & value);
 		void _validate(const std::shared_ptr<LILFlowControl> & value);
 		void _validate(const std::shared_ptr<LILFlowControlCall> & value);
@@ -483,6 +483,10 @@ bool LILColorMaker::_processColorInstr(std::shared_ptr<LILInstruction> value)
 			case InstructionTypeExpand:
 			case InstructionTypeGPU:
 			case InstructionTypeResource:
+			case InstructionTypeUnroll:
+			case InstructionTypeVectorize:
+			case InstructionTypeIndependent:
+			case InstructionTypeParallel:
 			{
 				//do nothing
 				break;
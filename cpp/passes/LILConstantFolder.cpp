@@ -8,21 +8,50 @@
  *
  *	  LICENSE: see LICENSE file
  *
- *	  This file tries to pre-bake strings from string functions
+ *	  This file tries to pre-bake strings from string functions and
+ *	  evaluates constant expressions and calls to pure functions
  *
  ********************************************************************/
 
 #include "LILConstantFolder.h"
+#include "LILAssignment.h"
+#include "LILBoolLiteral.h"
+#include "LILExpression.h"
+#include "LILFlowControl.h"
+#include "LILFlowControlCall.h"
+#include "LILFunctionCall.h"
+#include "LILFunctionDecl.h"
+#include "LILFunctionType.h"
+#include "LILIndexAccessor.h"
+#include "LILNodeToString.h"
+#include "LILNumberLiteral.h"
+#include "LILObjectDefinition.h"
+#include "LILPropertyName.h"
 #include "LILStringFunction.h"
 #include "LILStringLiteral.h"
 #include "LILRootNode.h"
+#include "LILType.h"
+#include "LILUnaryExpression.h"
+#include "LILValueList.h"
 #include "LILValuePath.h"
 #include "LILVarDecl.h"
 #include "LILVarName.h"
 
+//must match MSG_NAME_MAX, MSG_HASH_PRIME and the offset basis of msgId in std/msg.lil
+#define LIL_MSG_NAME_MAX 256
+#define LIL_MSG_HASH_OFFSET 14695981039346656037ULL
+#define LIL_MSG_HASH_PRIME 1099511628211ULL
+
+//bounds for the interpreter, so that folding a call never hangs the compiler
+#define LIL_EVALUATION_MAX_STEPS 100000
+#define LIL_EVALUATION_MAX_DEPTH 64
+
 using namespace LIL;
 
 LILConstantFolder::LILConstantFolder()
+: _evaluationSteps(0)
+, _evaluationDepth(0)
+, _loopRepeat(false)
 {
 }
 
@@ -81,70 +110,845 @@ void LILConstantFolder::processChildren(std::shared_ptr<LILNode> parent, const s
 void LILConstantFolder::process(std::shared_ptr<LILNode> node)
 {
 	this->processChildren(node, node->getChildNodes());
-	if (node->isA(NodeTypeStringFunction)) {
-		std::vector<std::shared_ptr<LILNode>> buf;
-		this->_nodeBuffer.push_back(buf);
-
+	//nodes kept in members of their parent are replaced when the parent is processed
+	if (this->_nodeBuffer.size() > 0 && this->_canBeFolded(node) && this->_parentTakesReplacement(node)) {
+		auto folded = this->_fold(node);
+		if (folded) {
+			this->addReplacementNode(folded);
+			return;
+		}
+	}
+	this->_foldOperands(node);
+	if (node->isA(NodeTypeFunctionCall)) {
+		this->_processMsgCall(std::static_pointer_cast<LILFunctionCall>(node));
+	}
+	else if (node->isA(NodeTypeStringFunction)) {
 		auto strFn = std::static_pointer_cast<LILStringFunction>(node);
 		const auto & childNodes = strFn->getNodes();
-		auto & midChunks = strFn->_midChunks;
-		if (childNodes.size() > 0 && childNodes.size() == midChunks.size()+1) {
-			bool doneWithFirstChunk = false;
-			size_t startIndex = 0;
-			std::vector<LILString> newChunks;
-			for (size_t i=0, j=childNodes.size(); i<j; i+=1) {
-				auto childNode = childNodes[i];
-				std::shared_ptr<LILNode> remoteNode = this->recursiveFindNode(childNode);
-				if (!remoteNode || !remoteNode->isA(NodeTypeVarDecl)) {
+		const auto & midChunks = strFn->_midChunks;
+		if (childNodes.size() == 0 || childNodes.size() != midChunks.size()+1) {
+			return;
+		}
+
+		//walk the pieces in order, merging every constant value with the chunks around it
+		std::vector<std::shared_ptr<LILNode>> newNodes;
+		std::vector<LILString> newMidChunks;
+		LILString newStartChunk;
+		LILString pending = strFn->_startChunk;
+		for (size_t i=0, j=childNodes.size(); i<j; i+=1) {
+			auto childNode = childNodes[i];
+			const LILString & chunkAfter = i < midChunks.size() ? midChunks.at(i) : strFn->_endChunk;
+			auto str = this->_constantStringValue(childNode);
+			if (str) {
+				pending.append(str->getValue().stripQuotes().data());
+				pending.append(chunkAfter.data());
+			} else {
+				if (newNodes.size() == 0) {
+					newStartChunk = pending;
+				} else {
+					newMidChunks.push_back(pending);
+				}
+				newNodes.push_back(childNode);
+				pending = chunkAfter;
+			}
+		}
+
+		if (newNodes.size() == 0) {
+			if (this->_nodeBuffer.size() == 0) {
+				return;
+			}
+			auto stringLiteral = std::make_shared<LILStringLiteral>();
+			stringLiteral->setSourceLocation(strFn->getSourceLocation());
+			stringLiteral->setValue(pending);
+			this->addReplacementNode(stringLiteral);
+		} else if (newNodes.size() < childNodes.size()) {
+			strFn->_startChunk = newStartChunk;
+			strFn->_midChunks = newMidChunks;
+			strFn->_endChunk = pending;
+			strFn->setNodes(std::move(newNodes));
+		}
+	}
+}
+
+void LILConstantFolder::_processMsgCall(std::shared_ptr<LILFunctionCall> fc)
+{
+	auto name = fc->getName();
+	if (name != "msgId" && name != "msgEmit" && name != "msgSub" && name != "msgUnsub") {
+		return;
+	}
+	auto args = fc->getArguments();
+	if (args.size() == 0 || !args.front()->isA(NodeTypeStringLiteral)) {
+		return;
+	}
+	auto str = std::static_pointer_cast<LILStringLiteral>(args.front());
+	if (!str->getIsCString()) {
+		return;
+	}
+	//the variants taking ids come from std/msg.lil, leave the call alone without them
+	if (!this->getRootNode()->getLocalVariable(name == "msgId" ? name : name+"Id")) {
+		return;
+	}
+	auto numTy = LILType::make("i64");
+	auto idLit = std::make_shared<LILNumberLiteral>();
+	idLit->setSourceLocation(str->getSourceLocation());
+	idLit->setValue(LILString::number((LILUnitI64)LILConstantFolder::msgId(str->getValue().stripQuotes().replaceEscapes())));
+	idLit->setType(numTy);
+
+	if (name == "msgId") {
+		if (this->_nodeBuffer.size() > 0) {
+			this->addReplacementNode(idLit);
+		}
+		return;
+	}
+	fc->setName(name+"Id");
+	args[0] = idLit;
+	fc->setArguments(args);
+	auto argTypes = fc->getArgumentTypes();
+	if (argTypes.size() > 0) {
+		argTypes[0] = numTy;
+		fc->setArgumentTypes(argTypes);
+	}
+}
+
+LILUnitI64 LILConstantFolder::msgId(const LILString & name)
+{
+	//64 bit FNV-1a over the signed bytes, like msgId in std/msg.lil
+	const auto & str = name.data();
+	uint64_t hash = LIL_MSG_HASH_OFFSET;
+	for (size_t i=0, j=std::min(str.length(), (size_t)LIL_MSG_NAME_MAX); i<j; i+=1) {
+		hash ^= (uint64_t)(int64_t)(signed char)str[i];
+		hash *= LIL_MSG_HASH_PRIME;
+	}
+	return (LILUnitI64)hash;
+}
+
+std::shared_ptr<LILStringLiteral> LILConstantFolder::_constantStringValue(std::shared_ptr<LILNode> node)
+{
+	if (node->isA(NodeTypeStringLiteral) || node->isA(NodeTypeCStringLiteral)) {
+		return std::static_pointer_cast<LILStringLiteral>(node);
+	}
+	auto vd = this->_findConstDecl(node);
+	if (!vd) {
+		return nullptr;
+	}
+	auto initVal = vd->getInitVal();
+	if (
+		initVal
+		&& (
+			initVal->isA(NodeTypeCStringLiteral)
+			|| initVal->isA(NodeTypeStringLiteral)
+		)
+	) {
+		return std::static_pointer_cast<LILStringLiteral>(initVal);
+	}
+	return nullptr;
+}
+
+void LILConstantFolder::addReplacementNode(std::shared_ptr<LILNode> node)
+{
+	this->_nodeBuffer.back().push_back(node);
+}
+
+std::shared_ptr<LILVarDecl> LILConstantFolder::_findConstDecl(std::shared_ptr<LILNode> node) const
+{
+	std::shared_ptr<LILNode> remoteNode = this->recursiveFindNode(node);
+	//const declarations are var decls with the const flag set
+	if (!remoteNode || !remoteNode->isA(NodeTypeVarDecl)) {
+		return nullptr;
+	}
+	auto vd = std::static_pointer_cast<LILVarDecl>(remoteNode);
+	if (!vd->getIsConst()) {
+		return nullptr;
+	}
+	return vd;
+}
+
+bool LILConstantFolder::_canBeFolded(std::shared_ptr<LILNode> node) const
+{
+	switch (node->getNodeType()) {
+		case NodeTypeExpression:
+			return true;
+		case NodeTypeFunctionCall:
+			return node->isA(FunctionCallTypeNone);
+		default:
+			return false;
+	}
+}
+
+bool LILConstantFolder::_parentTakesReplacement(std::shared_ptr<LILNode> node) const
+{
+	//only these keep the node in their child nodes alone, the rest would get out of sync
+	auto parent = node->getParentNode();
+	if (!parent) {
+		return false;
+	}
+	switch (parent->getNodeType()) {
+		case NodeTypeVarDecl:
+		case NodeTypeFunctionCall:
+		case NodeTypeFlowControlCall:
+		case NodeTypeValueList:
+			return true;
+		default:
+			return false;
+	}
+}
+
+void LILConstantFolder::_foldOperands(std::shared_ptr<LILNode> node)
+{
+	switch (node->getNodeType()) {
+		case NodeTypeExpression:
+		{
+			auto exp = std::static_pointer_cast<LILExpression>(node);
+			auto left = exp->getLeft();
+			if (left && this->_canBeFolded(left)) {
+				auto folded = this->_fold(left);
+				if (folded) {
+					exp->setLeft(folded);
+				}
+			}
+			auto right = exp->getRight();
+			if (right && this->_canBeFolded(right)) {
+				auto folded = this->_fold(right);
+				if (folded) {
+					exp->setRight(folded);
+				}
+			}
+			break;
+		}
+		case NodeTypeAssignment:
+		{
+			auto asgmt = std::static_pointer_cast<LILAssignment>(node);
+			auto value = asgmt->getValue();
+			if (value && this->_canBeFolded(value)) {
+				auto folded = this->_fold(value);
+				if (folded) {
+					asgmt->removeNode(value);
+					asgmt->setValue(folded);
+				}
+			}
+			break;
+		}
+		case NodeTypeUnaryExpression:
+		{
+			auto uexp = std::static_pointer_cast<LILUnaryExpression>(node);
+			auto value = uexp->getValue();
+			if (value && this->_canBeFolded(value)) {
+				auto folded = this->_fold(value);
+				if (folded) {
+					uexp->removeNode(value);
+					uexp->setValue(folded);
+				}
+			}
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+std::shared_ptr<LILNode> LILConstantFolder::_fold(std::shared_ptr<LILNode> node)
+{
+	auto ty = node->getType();
+	if (!ty || !ty->isA(TypeTypeSingle) || ty->getIsNullable()) {
+		return nullptr;
+	}
+	this->_evaluationSteps = 0;
+	this->_evaluationDepth = 0;
+	this->_loopRepeat = false;
+	std::map<LILString, std::shared_ptr<LILNode>> locals;
+	auto value = this->_evaluate(node, locals);
+	//the literal has to be a drop-in replacement, conversions are not inserted yet
+	if (!value || value->getType()->getName() != ty->getName()) {
+		return nullptr;
+	}
+	value->setSourceLocation(node->getSourceLocation());
+	if (this->getDebug()) {
+		std::cerr << "## folded " + LILNodeToString::stringify(node.get()).data() + " into " + LILNodeToString::stringify(value.get()).data() + " ##\n";
+	}
+	return value;
+}
+
+std::shared_ptr<LILNode> LILConstantFolder::_evaluate(std::shared_ptr<LILNode> node, std::map<LILString, std::shared_ptr<LILNode>> & locals)
+{
+	if (!node) {
+		return nullptr;
+	}
+	this->_evaluationSteps += 1;
+	if (this->_evaluationSteps > LIL_EVALUATION_MAX_STEPS) {
+		return nullptr;
+	}
+	switch (node->getNodeType()) {
+		case NodeTypeNumberLiteral:
+		{
+			auto ty = node->getType();
+			if (!ty || !ty->isA(TypeTypeSingle)) {
+				return nullptr;
+			}
+			if (LILType::isIntegerType(ty.get())) {
+				if (ty->getName() == "i128") {
+					return nullptr;
+				}
+				return this->_makeInteger(ty, std::static_pointer_cast<LILNumberLiteral>(node)->getValue().toLongLong());
+			} else if (LILType::isFloatType(ty.get())) {
+				return this->_makeFloat(ty, this->_floatValue(node));
+			}
+			return nullptr;
+		}
+		case NodeTypeBoolLiteral:
+		{
+			return this->_makeBool(std::static_pointer_cast<LILBoolLiteral>(node)->getValue());
+		}
+		case NodeTypeVarName:
+		{
+			auto vn = std::static_pointer_cast<LILVarName>(node);
+			auto it = locals.find(vn->getName());
+			if (it != locals.end()) {
+				return it->second;
+			}
+			auto vd = this->_findConstDecl(node);
+			if (!vd || this->_evaluationDepth >= LIL_EVALUATION_MAX_DEPTH) {
+				return nullptr;
+			}
+			//the value of a const does not depend on where it is read from
+			std::map<LILString, std::shared_ptr<LILNode>> constLocals;
+			this->_evaluationDepth += 1;
+			auto ret = this->_evaluate(vd->getInitVal(), constLocals);
+			this->_evaluationDepth -= 1;
+			return ret;
+		}
+		case NodeTypeExpression:
+		{
+			return this->_evaluateExpression(std::static_pointer_cast<LILExpression>(node), locals);
+		}
+		case NodeTypeFunctionCall:
+		{
+			return this->_evaluateCall(std::static_pointer_cast<LILFunctionCall>(node), locals);
+		}
+		case NodeTypeValuePath:
+		{
+			return this->_evaluateValuePath(std::static_pointer_cast<LILValuePath>(node), locals);
+		}
+		default:
+			return nullptr;
+	}
+}
+
+std::shared_ptr<LILNode> LILConstantFolder::_evaluateExpression(std::shared_ptr<LILExpression> exp, std::map<LILString, std::shared_ptr<LILNode>> & locals)
+{
+	auto left = this->_evaluate(exp->getLeft(), locals);
+	if (!left) {
+		return nullptr;
+	}
+	if (exp->isA(ExpressionTypeCast)) {
+		auto right = exp->getRight();
+		if (!right || !right->isA(NodeTypeType)) {
+			return nullptr;
+		}
+		return this->_evaluateCast(left, std::static_pointer_cast<LILType>(right));
+	}
+	auto right = this->_evaluate(exp->getRight(), locals);
+	if (!right) {
+		return nullptr;
+	}
+	return this->_evaluateOperation(exp->getExpressionType(), left, right);
+}
+
+std::shared_ptr<LILNode> LILConstantFolder::_evaluateOperation(ExpressionType expType, std::shared_ptr<LILNode> left, std::shared_ptr<LILNode> right) const
+{
+	auto ty = left->getType();
+	auto rightTy = right->getType();
+	if (ty->getName() != rightTy->getName()) {
+		//like the emitter, the narrower integer is sign extended to the width of the other one
+		//the values are kept sign extended already, so only the type of the result changes
+		if (!LILType::isIntegerType(ty.get()) || !LILType::isIntegerType(rightTy.get())) {
+			return nullptr;
+		}
+		if (rightTy->getName().substr(1).toLongLong() > ty->getName().substr(1).toLongLong()) {
+			ty = rightTy;
+		}
+	}
+
+	if (left->isA(NodeTypeBoolLiteral)) {
+		bool leftV = std::static_pointer_cast<LILBoolLiteral>(left)->getValue();
+		bool rightV = std::static_pointer_cast<LILBoolLiteral>(right)->getValue();
+		switch (expType) {
+			case ExpressionTypeEqualComparison:
+				return this->_makeBool(leftV == rightV);
+			case ExpressionTypeNotEqualComparison:
+			case ExpressionTypeXor:
+				return this->_makeBool(leftV != rightV);
+			case ExpressionTypeLogicalAnd:
+			case ExpressionTypeBitwiseAnd:
+				return this->_makeBool(leftV && rightV);
+			case ExpressionTypeLogicalOr:
+			case ExpressionTypeBitwiseOr:
+				return this->_makeBool(leftV || rightV);
+			default:
+				return nullptr;
+		}
+	}
+
+	if (LILType::isFloatType(ty.get())) {
+		LILUnitF64 leftV = this->_floatValue(left);
+		LILUnitF64 rightV = this->_floatValue(right);
+		switch (expType) {
+			case ExpressionTypeSum:
+				return this->_makeFloat(ty, leftV + rightV);
+			case ExpressionTypeSubtraction:
+				return this->_makeFloat(ty, leftV - rightV);
+			case ExpressionTypeMultiplication:
+				return this->_makeFloat(ty, leftV * rightV);
+			case ExpressionTypeDivision:
+				if (rightV == 0) {
+					return nullptr;
+				}
+				return this->_makeFloat(ty, leftV / rightV);
+			case ExpressionTypeEqualComparison:
+				return this->_makeBool(leftV == rightV);
+			case ExpressionTypeNotEqualComparison:
+				return this->_makeBool(leftV != rightV);
+			case ExpressionTypeBiggerComparison:
+				return this->_makeBool(leftV > rightV);
+			case ExpressionTypeBiggerOrEqualComparison:
+				return this->_makeBool(leftV >= rightV);
+			case ExpressionTypeSmallerComparison:
+				return this->_makeBool(leftV < rightV);
+			case ExpressionTypeSmallerOrEqualComparison:
+				return this->_makeBool(leftV <= rightV);
+			default:
+				return nullptr;
+		}
+	}
+
+	LILUnitI64 leftV = std::static_pointer_cast<LILNumberLiteral>(left)->getValue().toLongLong();
+	LILUnitI64 rightV = std::static_pointer_cast<LILNumberLiteral>(right)->getValue().toLongLong();
+	//wrapping math is done unsigned, _makeInteger truncates to the width of the type
+	uint64_t leftU = (uint64_t)leftV;
+	uint64_t rightU = (uint64_t)rightV;
+	LILUnitI64 bitWidth = ty->getName().substr(1).toLongLong();
+	switch (expType) {
+		case ExpressionTypeSum:
+			return this->_makeInteger(ty, (LILUnitI64)(leftU + rightU));
+		case ExpressionTypeSubtraction:
+			return this->_makeInteger(ty, (LILUnitI64)(leftU - rightU));
+		case ExpressionTypeMultiplication:
+			return this->_makeInteger(ty, (LILUnitI64)(leftU * rightU));
+		case ExpressionTypeDivision:
+		case ExpressionTypeMod:
+		{
+			//both would trap at runtime, so they are left for it
+			//the overflowing division is the one of the smallest value of the operand's width
+			LILUnitI64 typeMin = std::numeric_limits<LILUnitI64>::min();
+			if (bitWidth > 0 && bitWidth < 64) {
+				typeMin = -((LILUnitI64)1 << (bitWidth - 1));
+			}
+			if (rightV == 0 || (rightV == -1 && leftV == typeMin)) {
+				return nullptr;
+			}
+			return this->_makeInteger(ty, expType == ExpressionTypeDivision ? leftV / rightV : leftV % rightV);
+		}
+		case ExpressionTypeEqualComparison:
+			return this->_makeBool(leftV == rightV);
+		case ExpressionTypeNotEqualComparison:
+			return this->_makeBool(leftV != rightV);
+		case ExpressionTypeBiggerComparison:
+			return this->_makeBool(leftV > rightV);
+		case ExpressionTypeBiggerOrEqualComparison:
+			return this->_makeBool(leftV >= rightV);
+		case ExpressionTypeSmallerComparison:
+			return this->_makeBool(leftV < rightV);
+		case ExpressionTypeSmallerOrEqualComparison:
+			return this->_makeBool(leftV <= rightV);
+		case ExpressionTypeLogicalAnd:
+		case ExpressionTypeBitwiseAnd:
+			return this->_makeInteger(ty, leftV & rightV);
+		case ExpressionTypeLogicalOr:
+		case ExpressionTypeBitwiseOr:
+			return this->_makeInteger(ty, leftV | rightV);
+		case ExpressionTypeXor:
+			return this->_makeInteger(ty, leftV ^ rightV);
+		case ExpressionTypeShiftLeft:
+		case ExpressionTypeShiftRight:
+		{
+			//out of range shifts give poison in llvm
+			if (rightV < 0 || rightV >= bitWidth) {
+				return nullptr;
+			}
+			if (expType == ExpressionTypeShiftLeft) {
+				return this->_makeInteger(ty, (LILUnitI64)(leftU << rightV));
+			}
+			//arithmetic shift, like the emitter
+			return this->_makeInteger(ty, leftV < 0 ? ~(~leftV >> rightV) : leftV >> rightV);
+		}
+		default:
+			return nullptr;
+	}
+}
+
+std::shared_ptr<LILNode> LILConstantFolder::_evaluateCast(std::shared_ptr<LILNode> value, std::shared_ptr<LILType> ty) const
+{
+	if (!ty->isA(TypeTypeSingle) || ty->getIsNullable() || ty->getName() == "i128") {
+		return nullptr;
+	}
+	auto valueTy = value->getType();
+	if (!LILType::isNumberType(valueTy.get())) {
+		return nullptr;
+	}
+	bool fromFloat = LILType::isFloatType(valueTy.get());
+	if (LILType::isIntegerType(ty.get())) {
+		if (!fromFloat) {
+			return this->_makeInteger(ty, std::static_pointer_cast<LILNumberLiteral>(value)->getValue().toLongLong());
+		}
+		LILUnitF64 floatV = this->_floatValue(value);
+		//fptosi is poison out of range, leave those alone
+		LILUnitI64 bitWidth = ty->getName().substr(1).toLongLong();
+		LILUnitF64 limit = std::ldexp(1.0, (int)bitWidth - 1);
+		if (!(floatV > -limit - 1 && floatV < limit)) {
+			return nullptr;
+		}
+		return this->_makeInteger(ty, (LILUnitI64)floatV);
+	} else if (LILType::isFloatType(ty.get())) {
+		if (fromFloat) {
+			return this->_makeFloat(ty, this->_floatValue(value));
+		}
+		LILUnitI64 intV = std::static_pointer_cast<LILNumberLiteral>(value)->getValue().toLongLong();
+		//rounding twice could differ from sitofp, so only exact values are taken
+		if ((LILUnitI64)(LILUnitF64)intV != intV) {
+			return nullptr;
+		}
+		return this->_makeFloat(ty, (LILUnitF64)intV);
+	}
+	return nullptr;
+}
+
+std::shared_ptr<LILNode> LILConstantFolder::_evaluateCall(std::shared_ptr<LILFunctionCall> fc, std::map<LILString, std::shared_ptr<LILNode>> & locals)
+{
+	if (!fc->isA(FunctionCallTypeNone) || this->_evaluationDepth >= LIL_EVALUATION_MAX_DEPTH) {
+		return nullptr;
+	}
+	auto localNode = this->findNodeForName(fc->getName(), fc->getParentNode().get());
+	if (!localNode || !localNode->isA(NodeTypeFunctionDecl)) {
+		return nullptr;
+	}
+	auto fd = std::static_pointer_cast<LILFunctionDecl>(localNode);
+	auto fnTy = fd->getFnType();
+	if (
+		!fnTy
+		|| fd->getIsExtern()
+		|| fd->getHasMultipleImpls()
+		|| fd->getFinally()
+		|| fnTy->getIsVariadic()
+		|| this->findAncestorClass(fd)
+	) {
+		return nullptr;
+	}
+	auto returnTy = fnTy->getReturnType();
+	if (!returnTy || !returnTy->isA(TypeTypeSingle) || returnTy->getIsNullable()) {
+		return nullptr;
+	}
+	auto fnArgs = fnTy->getArguments();
+	auto callArgs = fc->getArguments();
+	if (fnArgs.size() != callArgs.size()) {
+		return nullptr;
+	}
+
+	//the callee sees nothing but its arguments, anything it cannot evaluate makes the call stay
+	std::map<LILString, std::shared_ptr<LILNode>> calleeLocals;
+	for (size_t i=0, j=fnArgs.size(); i<j; i+=1) {
+		auto fnArg = fnArgs[i];
+		if (!fnArg->isA(NodeTypeVarDecl)) {
+			return nullptr;
+		}
+		auto argVd = std::static_pointer_cast<LILVarDecl>(fnArg);
+		auto argValue = this->_evaluate(callArgs[i], locals);
+		auto argTy = argVd->getType();
+		if (!argValue || !argTy || !argTy->isA(TypeTypeSingle) || argTy->getName() != argValue->getType()->getName()) {
+			return nullptr;
+		}
+		calleeLocals[argVd->getName()] = argValue;
+	}
+
+	this->_evaluationDepth += 1;
+	bool loopRepeatBackup = this->_loopRepeat;
+	FlowControlCallType jump = FlowControlCallTypeNone;
+	std::shared_ptr<LILNode> ret;
+	bool success = this->_run(fd->getBody(), calleeLocals, jump, ret);
+	this->_loopRepeat = loopRepeatBackup;
+	this->_evaluationDepth -= 1;
+
+	if (!success || jump != FlowControlCallTypeReturn || !ret || ret->getType()->getName() != returnTy->getName()) {
+		return nullptr;
+	}
+	return ret;
+}
+
+std::shared_ptr<LILNode> LILConstantFolder::_evaluateValuePath(std::shared_ptr<LILValuePath> vp, std::map<LILString, std::shared_ptr<LILNode>> & locals)
+{
+	//reads out of static arrays and object literals that were declared const
+	const auto & nodes = vp->getNodes();
+	if (nodes.size() < 2 || !nodes.front()->isA(NodeTypeVarName)) {
+		return nullptr;
+	}
+	auto vd = this->_findConstDecl(nodes.front());
+	if (!vd) {
+		return nullptr;
+	}
+	auto current = vd->getInitVal();
+	for (size_t i=1, j=nodes.size(); i<j; i+=1) {
+		if (!current) {
+			return nullptr;
+		}
+		auto node = nodes[i];
+		if (node->isA(NodeTypeIndexAccessor)) {
+			if (!current->isA(NodeTypeValueList)) {
+				return nullptr;
+			}
+			auto index = this->_evaluate(std::static_pointer_cast<LILIndexAccessor>(node)->getArgument(), locals);
+			if (!index || !index->isA(NodeTypeNumberLiteral) || !LILType::isIntegerType(index->getType().get())) {
+				return nullptr;
+			}
+			LILUnitI64 indexV = std::static_pointer_cast<LILNumberLiteral>(index)->getValue().toLongLong();
+			auto values = std::static_pointer_cast<LILValueList>(current)->getValues();
+			if (indexV < 0 || indexV >= (LILUnitI64)values.size()) {
+				return nullptr;
+			}
+			current = values[indexV];
+		} else if (node->isA(NodeTypePropertyName)) {
+			if (!current->isA(NodeTypeObjectDefinition)) {
+				return nullptr;
+			}
+			auto pnName = std::static_pointer_cast<LILPropertyName>(node)->getName();
+			std::shared_ptr<LILNode> fieldValue;
+			for (auto objNode : std::static_pointer_cast<LILObjectDefinition>(current)->getNodes()) {
+				if (!objNode->isA(NodeTypeAssignment)) {
 					continue;
 				}
-				auto vd = std::static_pointer_cast<LILVarDecl>(remoteNode);
-				auto initVal = vd->getInitVal();
-				//FIXME: use static analysis to determine if the literal stays a literal
-				if (
-					initVal
-					&& (
-						initVal->isA(NodeTypeCStringLiteral)
-						|| initVal->isA(NodeTypeStringLiteral)
-					)
-				) {
-					auto str = std::static_pointer_cast<LILStringLiteral>(initVal);
-					if (!doneWithFirstChunk) {
-						strFn->_startChunk.append(str->getValue().stripQuotes().data());
-						if (midChunks.size() > i) {
-							strFn->_startChunk.append(midChunks.at(i).data());
-						} else {
-							strFn->_startChunk.append(strFn->_endChunk.data());
-						}
-						
-					} else {
-						std::string newChunk = str->getValue().data();
-						newChunk.append(midChunks.at(i).data());
-						newChunks.push_back(newChunk);
-					}
-				} else {
-					if (!doneWithFirstChunk) {
-						doneWithFirstChunk = true;
-						startIndex = i;
-					}
+				auto asgmt = std::static_pointer_cast<LILAssignment>(objNode);
+				auto subj = asgmt->getSubject();
+				if (subj && subj->isA(NodeTypePropertyName) && std::static_pointer_cast<LILPropertyName>(subj)->getName() == pnName) {
+					fieldValue = asgmt->getValue();
+					break;
 				}
 			}
-			if (!doneWithFirstChunk)
+			current = fieldValue;
+		} else {
+			return nullptr;
+		}
+	}
+	std::map<LILString, std::shared_ptr<LILNode>> constLocals;
+	return this->_evaluate(current, constLocals);
+}
+
+bool LILConstantFolder::_run(const std::vector<std::shared_ptr<LILNode>> & nodes, std::map<LILString, std::shared_ptr<LILNode>> & locals, FlowControlCallType & outJump, std::shared_ptr<LILNode> & outValue)
+{
+	for (const auto & node : nodes) {
+		this->_evaluationSteps += 1;
+		if (this->_evaluationSteps > LIL_EVALUATION_MAX_STEPS) {
+			return false;
+		}
+		switch (node->getNodeType()) {
+			case NodeTypeVarDecl:
 			{
-				auto stringLiteral = std::make_shared<LILStringLiteral>();
-				stringLiteral->setValue(strFn->_startChunk);
-				this->addReplacementNode(stringLiteral);
+				auto vd = std::static_pointer_cast<LILVarDecl>(node);
+				auto ty = vd->getType();
+				//a flat map of locals cannot tell shadowed names apart
+				if (locals.count(vd->getName()) || !ty || !ty->isA(TypeTypeSingle)) {
+					return false;
+				}
+				auto value = this->_evaluate(vd->getInitVal(), locals);
+				if (!value || value->getType()->getName() != ty->getName()) {
+					return false;
+				}
+				locals[vd->getName()] = value;
+				break;
 			}
-			else
+			case NodeTypeAssignment:
 			{
-				std::cerr << "!!!! UNIMPLEMENTED FAIL !!!!!!!! \n";
-				return;
+				auto asgmt = std::static_pointer_cast<LILAssignment>(node);
+				auto subj = asgmt->getSubject();
+				if (!subj || !subj->isA(NodeTypeVarName)) {
+					return false;
+				}
+				auto name = std::static_pointer_cast<LILVarName>(subj)->getName();
+				auto it = locals.find(name);
+				if (it == locals.end()) {
+					return false;
+				}
+				auto value = this->_evaluate(asgmt->getValue(), locals);
+				if (!value || value->getType()->getName() != it->second->getType()->getName()) {
+					return false;
+				}
+				it->second = value;
+				break;
+			}
+			case NodeTypeUnaryExpression:
+			{
+				auto uexp = std::static_pointer_cast<LILUnaryExpression>(node);
+				auto subj = uexp->getSubject();
+				if (!subj || !subj->isA(NodeTypeVarName)) {
+					return false;
+				}
+				auto name = std::static_pointer_cast<LILVarName>(subj)->getName();
+				auto it = locals.find(name);
+				if (it == locals.end()) {
+					return false;
+				}
+				auto value = this->_evaluate(uexp->getValue(), locals);
+				if (!value) {
+					return false;
+				}
+				auto result = this->_evaluateOperation(LILUnaryExpression::uexpToExpType(uexp->getUnaryExpressionType()), it->second, value);
+				//the emitter only widens the value, not the variable
+				if (!result || result->getType()->getName() != it->second->getType()->getName()) {
+					return false;
+				}
+				it->second = result;
+				break;
+			}
+			case NodeTypeFlowControl:
+			{
+				auto fc = std::static_pointer_cast<LILFlowControl>(node);
+				if (fc->isA(FlowControlTypeIf)) {
+					const auto & args = fc->getArguments();
+					if (args.size() != 1) {
+						return false;
+					}
+					auto condition = this->_evaluate(args.front(), locals);
+					if (!condition || !condition->isA(NodeTypeBoolLiteral)) {
+						return false;
+					}
+					bool isTrue = std::static_pointer_cast<LILBoolLiteral>(condition)->getValue();
+					if (!this->_runBlock(isTrue ? fc->getThen() : fc->getElse(), locals, outJump, outValue)) {
+						return false;
+					}
+				} else if (fc->isA(FlowControlTypeLoop) && fc->getArguments().size() == 0) {
+					//repeat only raises a flag, the rest of the body still runs
+					bool loopRepeatBackup = this->_loopRepeat;
+					do {
+						this->_loopRepeat = false;
+						if (!this->_runBlock(fc->getThen(), locals, outJump, outValue)) {
+							return false;
+						}
+						if (outJump == FlowControlCallTypeBreak) {
+							outJump = FlowControlCallTypeNone;
+							this->_loopRepeat = false;
+						}
+					} while (this->_loopRepeat && outJump == FlowControlCallTypeNone);
+					this->_loopRepeat = loopRepeatBackup;
+				} else {
+					return false;
+				}
+				if (outJump != FlowControlCallTypeNone) {
+					return true;
+				}
+				break;
 			}
+			case NodeTypeFlowControlCall:
+			{
+				auto fcc = std::static_pointer_cast<LILFlowControlCall>(node);
+				switch (fcc->getFlowControlCallType()) {
+					case FlowControlCallTypeReturn:
+					{
+						outValue = this->_evaluate(fcc->getArgument(), locals);
+						if (!outValue) {
+							return false;
+						}
+						outJump = FlowControlCallTypeReturn;
+						return true;
+					}
+					case FlowControlCallTypeRepeat:
+					{
+						this->_loopRepeat = true;
+						break;
+					}
+					case FlowControlCallTypeBreak:
+					{
+						outJump = FlowControlCallTypeBreak;
+						return true;
+					}
+					default:
+						return false;
+				}
+				break;
+			}
+			default:
+				return false;
 		}
 	}
+	return true;
 }
 
-void LILConstantFolder::addReplacementNode(std::shared_ptr<LILNode> node)
+bool LILConstantFolder::_runBlock(const std::vector<std::shared_ptr<LILNode>> & nodes, std::map<LILString, std::shared_ptr<LILNode>> & locals, FlowControlCallType & outJump, std::shared_ptr<LILNode> & outValue)
 {
-	this->_nodeBuffer.back().push_back(node);
+	//locals declared inside the block end with it, so that a loop can declare them again on the next pass
+	std::map<LILString, std::shared_ptr<LILNode>> blockLocals = locals;
+	if (!this->_run(nodes, blockLocals, outJump, outValue)) {
+		return false;
+	}
+	for (auto & pair : locals) {
+		pair.second = blockLocals[pair.first];
+	}
+	return true;
+}
+
+std::shared_ptr<LILNode> LILConstantFolder::_makeInteger(std::shared_ptr<LILType> ty, LILUnitI64 value) const
+{
+	const auto & name = ty->getName();
+	if (name == "i8") {
+		value = (int8_t)value;
+	} else if (name == "i16") {
+		value = (int16_t)value;
+	} else if (name == "i32") {
+		value = (int32_t)value;
+	} else if (name != "i64") {
+		return nullptr;
+	}
+	auto ret = std::make_shared<LILNumberLiteral>();
+	ret->setValue(LILString::number(value));
+	ret->setType(LILType::make(name));
+	return ret;
+}
+
+std::shared_ptr<LILNode> LILConstantFolder::_makeFloat(std::shared_ptr<LILType> ty, LILUnitF64 value) const
+{
+	const auto & name = ty->getName();
+	if (!std::isfinite(value)) {
+		return nullptr;
+	}
+	//only fold what survives the trip through the literal exactly
+	LILString str;
+	if (name == "f32") {
+		str = LILString::number((LILUnitF32)value);
+		if (str.toFloat() != (LILUnitF32)value) {
+			return nullptr;
+		}
+	} else if (name == "f64") {
+		str = LILString::number(value);
+		if (str.toDouble() != value) {
+			return nullptr;
+		}
+	} else {
+		return nullptr;
+	}
+	auto ret = std::make_shared<LILNumberLiteral>();
+	ret->setValue(str);
+	ret->setType(LILType::make(name));
+	return ret;
+}
+
+LILUnitF64 LILConstantFolder::_floatValue(std::shared_ptr<LILNode> node) const
+{
+	//read the literal like the emitter does, f32 ones are rounded to float right away
+	auto value = std::static_pointer_cast<LILNumberLiteral>(node)->getValue();
+	if (node->getType()->getName() == "f32") {
+		return value.toFloat();
+	}
+	return value.toDouble();
+}
+
+std::shared_ptr<LILNode> LILConstantFolder::_makeBool(bool value) const
+{
+	auto ret = std::make_shared<LILBoolLiteral>();
+	ret->setValue(value);
+	return ret;
 }
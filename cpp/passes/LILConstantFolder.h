@@ -8,7 +8,8 @@
  *
  *	  LICENSE: see LICENSE file
  *
- *	  This file tries to pre-bake strings from string functions
+ *	  This file tries to pre-bake strings from string functions and
+ *	  evaluates constant expressions and calls to pure functions
  *
  ********************************************************************/
 
@@ -19,6 +20,13 @@
 
 namespace LIL
 {
+	class LILExpression;
+	class LILFunctionCall;
+	class LILStringLiteral;
+	class LILType;
+	class LILValuePath;
+	class LILVarDecl;
+
 	class LILConstantFolder : public LILVisitor
 	{
 	public:
@@ -33,9 +41,35 @@ namespace LIL
 		inline void processChildren(std::shared_ptr<LILNode> parent, const std::vector<std::shared_ptr<LILNode> > &nodes);
 		void process(std::shared_ptr<LILNode> node);
 		void addReplacementNode(std::shared_ptr<LILNode> node);
+		static LILUnitI64 msgId(const LILString & name);
 
 	private:
 		std::vector<std::vector<std::shared_ptr<LILNode>>> _nodeBuffer;
+		size_t _evaluationSteps;
+		size_t _evaluationDepth;
+		bool _loopRepeat;
+
+		std::shared_ptr<LILStringLiteral> _constantStringValue(std::shared_ptr<LILNode> node);
+		std::shared_ptr<LILVarDecl> _findConstDecl(std::shared_ptr<LILNode> node) const;
+		void _processMsgCall(std::shared_ptr<LILFunctionCall> fc);
+		bool _canBeFolded(std::shared_ptr<LILNode> node) const;
+		bool _parentTakesReplacement(std::shared_ptr<LILNode> node) const;
+		void _foldOperands(std::shared_ptr<LILNode> node);
+		std::shared_ptr<LILNode> _fold(std::shared_ptr<LILNode> node);
+
+		//the interpreter, values are number or bool literals and the locals are keyed by name
+		std::shared_ptr<LILNode> _evaluate(std::shared_ptr<LILNode> node, std::map<LILString, std::shared_ptr<LILNode>> & locals);
+		std::shared_ptr<LILNode> _evaluateExpression(std::shared_ptr<LILExpression> exp, std::map<LILString, std::shared_ptr<LILNode>> & locals);
+		std::shared_ptr<LILNode> _evaluateOperation(ExpressionType expType, std::shared_ptr<LILNode> left, std::shared_ptr<LILNode> right) const;
+		std::shared_ptr<LILNode> _evaluateCast(std::shared_ptr<LILNode> value, std::shared_ptr<LILType> ty) const;
+		std::shared_ptr<LILNode> _evaluateCall(std::shared_ptr<LILFunctionCall> fc, std::map<LILString, std::shared_ptr<LILNode>> & locals);
+		std::shared_ptr<LILNode> _evaluateValuePath(std::shared_ptr<LILValuePath> vp, std::map<LILString, std::shared_ptr<LILNode>> & locals);
+		bool _run(const std::vector<std::shared_ptr<LILNode>> & nodes, std::map<LILString, std::shared_ptr<LILNode>> & locals, FlowControlCallType & outJump, std::shared_ptr<LILNode> & outValue);
+		bool _runBlock(const std::vector<std::shared_ptr<LILNode>> & nodes, std::map<LILString, std::shared_ptr<LILNode>> & locals, FlowControlCallType & outJump, std::shared_ptr<LILNode> & outValue);
+		std::shared_ptr<LILNode> _makeInteger(std::shared_ptr<LILType> ty, LILUnitI64 value) const;
+		std::shared_ptr<LILNode> _makeFloat(std::shared_ptr<LILType> ty, LILUnitF64 value) const;
+		std::shared_ptr<LILNode> _makeBool(bool value) const;
+		LILUnitF64 _floatValue(std::shared_ptr<LILNode> node) const;
 	};
 }
 
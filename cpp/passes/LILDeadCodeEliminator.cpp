@@ -0,0 +1,455 @@
+/********************************************************************
+ *
+ *	  LIL Is a Language
+ *
+ *	  AUTHORS: Miro Keller
+ *
+ *	  COPYRIGHT: ©2020-today:  All Rights Reserved
+ *
+ *	  LICENSE: see LICENSE file
+ *
+ *	  This file removes functions, classes and globals that can't be
+ *	  reached from the entry points of the code unit
+ *
+ ********************************************************************/
+
+#include "LILDeadCodeEliminator.h"
+#include "../ast/LILAliasDecl.h"
+#include "../ast/LILClassDecl.h"
+#include "../ast/LILFlowControl.h"
+#include "../ast/LILForeignLang.h"
+#include "../ast/LILFunctionCall.h"
+#include "../ast/LILFunctionDecl.h"
+#include "../ast/LILFunctionType.h"
+#include "../ast/LILMultipleType.h"
+#include "../ast/LILPointerType.h"
+#include "../ast/LILRootNode.h"
+#include "../ast/LILRule.h"
+#include "../ast/LILSIMDType.h"
+#include "../ast/LILStaticArrayType.h"
+#include "../ast/LILStringLiteral.h"
+#include "../ast/LILTypeDecl.h"
+#include "../ast/LILVarDecl.h"
+#include "../ast/LILVarName.h"
+
+using namespace LIL;
+
+LILDeadCodeEliminator::LILDeadCodeEliminator()
+: _keepExported(true)
+{
+}
+
+LILDeadCodeEliminator::~LILDeadCodeEliminator()
+{
+}
+
+void LILDeadCodeEliminator::initializeVisit()
+{
+	if (this->getVerbose()) {
+		std::cerr << "\n\n";
+		std::cerr << "===============================\n";
+		std::cerr << "===  DEAD CODE ELIMINATION  ===\n";
+		std::cerr << "===============================\n\n";
+	}
+}
+
+void LILDeadCodeEliminator::setKeepExported(bool value)
+{
+	this->_keepExported = value;
+}
+
+bool LILDeadCodeEliminator::getKeepExported() const
+{
+	return this->_keepExported;
+}
+
+void LILDeadCodeEliminator::performVisit(std::shared_ptr<LILRootNode> rootNode)
+{
+	this->setRootNode(rootNode);
+	this->_declarations.clear();
+	this->_markedNames.clear();
+	this->_scanned.clear();
+	this->_pending.clear();
+
+	//index everything that may be dropped by name
+	for (const auto & node : rootNode->getNodes()) {
+		if (!this->_isRemovable(node.get())) {
+			continue;
+		}
+		switch (node->getNodeType()) {
+			case NodeTypeFunctionDecl:
+			{
+				auto fd = std::static_pointer_cast<LILFunctionDecl>(node);
+				this->_declarations[fd->getName()].push_back(node);
+				if (fd->getUnmangledName() != fd->getName()) {
+					this->_declarations[fd->getUnmangledName()].push_back(node);
+				}
+				for (const auto & impl : fd->getImpls()) {
+					if (impl->getName() != fd->getName()) {
+						this->_declarations[impl->getName()].push_back(node);
+					}
+				}
+				break;
+			}
+			case NodeTypeClassDecl:
+			{
+				auto cd = std::static_pointer_cast<LILClassDecl>(node);
+				this->_declarations[cd->getName()].push_back(node);
+				break;
+			}
+			case NodeTypeVarDecl:
+			{
+				auto vd = std::static_pointer_cast<LILVarDecl>(node);
+				this->_declarations[vd->getName()].push_back(node);
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	//everything else is kept, so it counts as an entry point as well
+	for (const auto & node : rootNode->getNodes()) {
+		if (!this->_isRemovable(node.get()) || this->_isEntryPoint(node.get())) {
+			this->_pending.push_back(node);
+		}
+	}
+	for (const auto & node : rootNode->getInitializers()) {
+		this->_pending.push_back(node);
+	}
+	if (rootNode->hasRules()) {
+		this->_mark("container");
+		this->_mark("element");
+	}
+
+	while (this->_pending.size() > 0) {
+		auto node = this->_pending.back();
+		this->_pending.pop_back();
+		this->_scan(node.get());
+	}
+
+	std::vector<std::shared_ptr<LILNode>> deadNodes;
+	for (const auto & node : rootNode->getNodes()) {
+		if (this->_isRemovable(node.get()) && this->_scanned.count(node.get()) == 0) {
+			deadNodes.push_back(node);
+		}
+	}
+	for (const auto & node : deadNodes) {
+		if (this->getDebug()) {
+			std::cerr << "## removing " + LILNode::nodeTypeToString(node->getNodeType()).data() + " ";
+			switch (node->getNodeType()) {
+				case NodeTypeFunctionDecl:
+					std::cerr << std::static_pointer_cast<LILFunctionDecl>(node)->getName().data();
+					break;
+				case NodeTypeClassDecl:
+					std::cerr << std::static_pointer_cast<LILClassDecl>(node)->getName().data();
+					break;
+				case NodeTypeVarDecl:
+					std::cerr << std::static_pointer_cast<LILVarDecl>(node)->getName().data();
+					break;
+				default:
+					break;
+			}
+			std::cerr << " ##\n";
+		}
+		if (node->isA(NodeTypeClassDecl)) {
+			rootNode->removeClass(std::static_pointer_cast<LILClassDecl>(node));
+		}
+		rootNode->removeNode(node);
+	}
+	if (this->getVerbose()) {
+		std::cerr << "Removed " << deadNodes.size() << " unreachable declarations\n";
+	}
+}
+
+bool LILDeadCodeEliminator::_isRemovable(LILNode * node) const
+{
+	switch (node->getNodeType()) {
+		case NodeTypeFunctionDecl:
+			return true;
+		case NodeTypeClassDecl:
+		{
+			//templates are never emitted, only their specializations are
+			auto cd = static_cast<LILClassDecl *>(node);
+			return !cd->isTemplate();
+		}
+		case NodeTypeVarDecl:
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool LILDeadCodeEliminator::_isEntryPoint(LILNode * node) const
+{
+	LILString name;
+	bool isExtern = false;
+	switch (node->getNodeType()) {
+		case NodeTypeFunctionDecl:
+		{
+			auto fd = static_cast<LILFunctionDecl *>(node);
+			isExtern = fd->getIsExtern();
+			name = fd->getName();
+			break;
+		}
+		case NodeTypeClassDecl:
+		{
+			auto cd = static_cast<LILClassDecl *>(node);
+			isExtern = cd->getIsExtern();
+			name = cd->getName();
+			break;
+		}
+		case NodeTypeVarDecl:
+		{
+			auto vd = static_cast<LILVarDecl *>(node);
+			isExtern = vd->getIsExtern();
+			//the initializer runs at startup even if nobody reads the var
+			if (!isExtern && this->_hasSideEffects(vd->getInitVal().get())) {
+				return true;
+			}
+			name = vd->getName();
+			break;
+		}
+		default:
+			return true;
+	}
+	//the runtime is called by the native shell and looked up by name in the emitter,
+	//so even the extern declarations of it need to stay
+	if (name.length() > 5 && name.substr(0, 5) == "LIL__") {
+		return true;
+	}
+	if (isExtern) {
+		return false;
+	}
+	//other objects may link against these. Which ones they do isn't known here, since the
+	//objects of std are cached and shared by every program, so the linker removes the
+	//unused ones instead (see --gc-sections and -dead_strip in configure_defaults.lil).
+	//Until then they still go through the IR emitter and the optimizer, and nothing drops
+	//them in jit mode or when linking with -r, like the ios targets do
+	if (this->_keepExported && node->getIsExported()) {
+		return true;
+	}
+	return name == "main";
+}
+
+bool LILDeadCodeEliminator::_hasSideEffects(LILNode * node) const
+{
+	if (!node) {
+		return false;
+	}
+	switch (node->getNodeType()) {
+		case NodeTypeFunctionCall:
+		case NodeTypeObjectDefinition:
+		case NodeTypeInstruction:
+			return true;
+		default:
+			break;
+	}
+	for (const auto & child : node->getChildNodes()) {
+		if (this->_hasSideEffects(child.get())) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void LILDeadCodeEliminator::_mark(const LILString & name)
+{
+	if (this->_markedNames.count(name.data()) > 0) {
+		return;
+	}
+	this->_markedNames[name.data()] = true;
+	//long string literals are copied to the heap by the emitter
+	if (name == "string") {
+		this->_mark("malloc");
+	}
+	auto it = this->_declarations.find(name);
+	if (it == this->_declarations.end()) {
+		return;
+	}
+	for (const auto & node : it->second) {
+		this->_pending.push_back(node);
+	}
+}
+
+void LILDeadCodeEliminator::_markType(LILType * ty)
+{
+	if (!ty) {
+		return;
+	}
+	this->_mark(ty->getName());
+	for (const auto & param : ty->getTmplParams()) {
+		this->_scan(param.get());
+	}
+	switch (ty->getTypeType()) {
+		case TypeTypePointer:
+		{
+			auto ptrTy = static_cast<LILPointerType *>(ty);
+			this->_markType(ptrTy->getArgument().get());
+			break;
+		}
+		case TypeTypeMultiple:
+		{
+			auto multiTy = static_cast<LILMultipleType *>(ty);
+			for (const auto & innerTy : multiTy->getTypes()) {
+				this->_markType(innerTy.get());
+			}
+			break;
+		}
+		case TypeTypeStaticArray:
+		{
+			auto saTy = static_cast<LILStaticArrayType *>(ty);
+			this->_markType(saTy->getType().get());
+			break;
+		}
+		case TypeTypeSIMD:
+		{
+			auto simdTy = static_cast<LILSIMDType *>(ty);
+			this->_markType(simdTy->getType().get());
+			break;
+		}
+		case TypeTypeFunction:
+		{
+			auto fnTy = static_cast<LILFunctionType *>(ty);
+			for (const auto & arg : fnTy->getArguments()) {
+				this->_scan(arg.get());
+			}
+			this->_markType(fnTy->getReturnType().get());
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+void LILDeadCodeEliminator::_scan(LILNode * node)
+{
+	if (!node || this->_scanned.count(node) > 0) {
+		return;
+	}
+	this->_scanned[node] = true;
+
+	if (node->isA(NodeTypeType)) {
+		this->_markType(static_cast<LILType *>(node));
+		return;
+	}
+	this->_markType(node->getType().get());
+
+	switch (node->getNodeType()) {
+		case NodeTypeFunctionCall:
+		{
+			auto fc = static_cast<LILFunctionCall *>(node);
+			this->_mark(fc->getName());
+			break;
+		}
+		case NodeTypeVarName:
+		{
+			//also covers functions that are passed around as pointers
+			auto vn = static_cast<LILVarName *>(node);
+			this->_mark(vn->getName());
+			break;
+		}
+		case NodeTypeStringLiteral:
+		{
+			auto str = static_cast<LILStringLiteral *>(node);
+			if (!str->getIsCString()) {
+				this->_mark("string");
+			}
+			break;
+		}
+		case NodeTypeSelectorChain:
+		{
+			this->_mark("container");
+			this->_mark("element");
+			break;
+		}
+		case NodeTypeSelector:
+		{
+			if (node->getSelectorType() == SelectorTypeNameSelector) {
+				this->_mark("LIL__nameToNameId");
+				this->_mark("LIL__selectByName");
+			}
+			break;
+		}
+		case NodeTypeFlowControl:
+		{
+			auto fc = static_cast<LILFlowControl *>(node);
+			if (fc->getIsParallel()) {
+				this->_mark("LIL__parallelFor");
+			}
+			break;
+		}
+		case NodeTypeForeignLang:
+		{
+			//we can't parse foreign code, so anything it mentions stays
+			auto fl = static_cast<LILForeignLang *>(node);
+			const auto & content = fl->getContent().data();
+			for (const auto & it : this->_declarations) {
+				if (content.find(it.first.data()) != std::string::npos) {
+					this->_mark(it.first);
+				}
+			}
+			break;
+		}
+		case NodeTypeFunctionDecl:
+		{
+			auto fd = static_cast<LILFunctionDecl *>(node);
+			for (const auto & bodyNode : fd->getBody()) {
+				this->_scan(bodyNode.get());
+			}
+			this->_scan(fd->getFinally().get());
+			for (const auto & impl : fd->getImpls()) {
+				this->_scan(impl.get());
+			}
+			break;
+		}
+		case NodeTypeClassDecl:
+		{
+			auto cd = static_cast<LILClassDecl *>(node);
+			this->_scan(cd->getInheritType().get());
+			for (const auto & field : cd->getFields()) {
+				this->_scan(field.get());
+			}
+			for (const auto & methodPair : cd->getMethods()) {
+				this->_scan(methodPair.second.get());
+			}
+			for (const auto & other : cd->getOther()) {
+				this->_scan(other.get());
+			}
+			break;
+		}
+		case NodeTypeRule:
+		{
+			auto rule = static_cast<LILRule *>(node);
+			this->_scan(rule->getSelectorChain().get());
+			for (const auto & value : rule->getValues()) {
+				this->_scan(value.get());
+			}
+			for (const auto & childRule : rule->getChildRules()) {
+				this->_scan(childRule.get());
+			}
+			this->_scan(rule->getInstruction().get());
+			break;
+		}
+		case NodeTypeAliasDecl:
+		{
+			auto ad = static_cast<LILAliasDecl *>(node);
+			this->_markType(ad->getSrcType().get());
+			this->_markType(ad->getDstType().get());
+			break;
+		}
+		case NodeTypeTypeDecl:
+		{
+			auto td = static_cast<LILTypeDecl *>(node);
+			this->_markType(td->getSrcType().get());
+			this->_markType(td->getDstType().get());
+			break;
+		}
+		default:
+			break;
+	}
+
+	for (const auto & child : node->getChildNodes()) {
+		this->_scan(child.get());
+	}
+}
@@ -0,0 +1,51 @@
+/********************************************************************
+ *
+ *	  LIL Is a Language
+ *
+ *	  AUTHORS: Miro Keller
+ *
+ *	  COPYRIGHT: ©2020-today:  All Rights Reserved
+ *
+ *	  LICENSE: see LICENSE file
+ *
+ *	  This file removes functions, classes and globals that can't be
+ *	  reached from the entry points of the code unit
+ *
+ ********************************************************************/
+
+#ifndef LILDEADCODEELIMINATOR_H
+#define LILDEADCODEELIMINATOR_H
+
+#include "../shared/LILVisitor.h"
+
+namespace LIL {
+	class LILRootNode;
+	class LILType;
+
+	class LILDeadCodeEliminator : public LILVisitor
+	{
+	public:
+		LILDeadCodeEliminator();
+		virtual ~LILDeadCodeEliminator();
+		void initializeVisit() override;
+		void performVisit(std::shared_ptr<LILRootNode> rootNode) override;
+		void setKeepExported(bool value);
+		bool getKeepExported() const;
+
+	private:
+		bool _keepExported;
+		std::map<LILString, std::vector<std::shared_ptr<LILNode>>> _declarations;
+		std::unordered_map<std::string, bool> _markedNames;
+		std::unordered_map<LILNode *, bool> _scanned;
+		std::vector<std::shared_ptr<LILNode>> _pending;
+
+		bool _isRemovable(LILNode * node) const;
+		bool _isEntryPoint(LILNode * node) const;
+		bool _hasSideEffects(LILNode * node) const;
+		void _mark(const LILString & name);
+		void _markType(LILType * ty);
+		void _scan(LILNode * node);
+	};
+}
+
+#endif /* LILDEADCODEELIMINATOR_H */
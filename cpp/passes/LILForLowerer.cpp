@@ -16,8 +16,11 @@
 #include "LILForLowerer.h"
 #include "../shared/LILErrorMessage.h"
 #include "../ast/LILAssignment.h"
+#include "../ast/LILClassDecl.h"
 #include "../ast/LILExpression.h"
 #include "../ast/LILFlowControl.h"
+#include "../ast/LILFunctionDecl.h"
+#include "../ast/LILFunctionType.h"
 #include "../ast/LILNumberLiteral.h"
 #include "../ast/LILPropertyName.h"
 #include "../ast/LILRootNode.h"
@@ -182,4 +185,20 @@ void LILForLowerer::_createForArgsObject(LILFlowControl * fc, LILNode * arg, LIL
 	plusOne->setValue(oneLit);
 	newArgs.push_back(plusOne);
 	fc->setArguments(std::move(newArgs));
+
+	//classes that hand out their elements as one block, through a data method returning
+	//a pointer next to the size field, are read straight from it instead of through value()
+	auto dataMeth = cd->getMethodNamed("data");
+	if (dataMeth && dataMeth->isA(NodeTypeFunctionDecl) && cd->getFieldNamed("size")) {
+		auto dataFnTy = std::static_pointer_cast<LILFunctionDecl>(dataMeth)->getFnType();
+		if (
+			dataFnTy
+			&& dataFnTy->getArguments().size() == 0
+			&& dataFnTy->getReturnType()
+			&& dataFnTy->getReturnType()->isA(TypeTypePointer)
+			&& !dataFnTy->getReturnType()->getIsNullable()
+		) {
+			fc->setIteratesData(true);
+		}
+	}
 }
@@ -327,6 +327,12 @@ void LILPathExpander::_process(LILValuePath * vp)
 					currentTy = saTy->getType();
 					newNodes.push_back(node->clone());
 				}
+				else if (currentTy->isA(TypeTypePointer))
+				{
+					auto ptrTy = std::static_pointer_cast<LILPointerType>(currentTy);
+					currentTy = ptrTy->getArgument();
+					newNodes.push_back(node->clone());
+				}
 				else
 				{
 					std::cerr << "FIELD TYPE IS NOT ARRAY TYPE FAIL!!!!\n";
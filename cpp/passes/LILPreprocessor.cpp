@@ -24,6 +24,7 @@
 #include "LILConfiguration.h"
 #include "LILErrorMessage.h"
 #include "LILFunctionDecl.h"
+#include "LILImportCache.h"
 #include "LILInstruction.h"
 #include "LILNodeToString.h"
 #include "LILNumberLiteral.h"
@@ -39,6 +40,7 @@ LILPreprocessor::LILPreprocessor()
 : _debugAST(false)
 , _needsAnotherPass(false)
 , _config(nullptr)
+, _importCache(nullptr)
 {
 }
 
@@ -121,10 +123,42 @@ void LILPreprocessor::processImportingInstr(const std::shared_ptr<LILRootNode> &
 					if (this->getVerbose() && instr->getVerbose()) {
 						std::cerr << "File " << path.data() << " was already imported. Skipping.\n\n";
 					}
+					this->addSourceFile(this->_getSourcePath(path));
 					auto aiNodes = this->getNodesForAlreadyImportedFile(path, isNeeds);
 					resultNodes.insert(resultNodes.end(), aiNodes.begin(), aiNodes.end());
 					continue;
 				}
+				std::string cacheKey;
+				if (this->_importCache) {
+					std::vector<LILString> alreadyImported;
+					const auto & alreadyImportedFiles = isNeeds ? this->_alreadyImportedFilesNeeds : this->_alreadyImportedFilesImport;
+					for (const auto & pair : alreadyImportedFiles) {
+						alreadyImported.push_back(pair.first);
+					}
+					cacheKey = this->_importCache->makeKey(path, isNeeds, this->_suffix, this->getConstants(), alreadyImported);
+					std::vector<std::shared_ptr<LILNode>> cachedNodes;
+					std::vector<std::pair<LILString, bool>> cachedNeededFiles;
+					std::vector<LILString> cachedResources;
+					std::vector<LILString> cachedSourceFiles;
+					if (this->_importCache->get(cacheKey, cachedNodes, cachedNeededFiles, cachedResources, cachedSourceFiles)) {
+						if (this->getVerbose() && instr->getVerbose()) {
+							std::cerr << "Using cached " << path.data() << "\n\n";
+						}
+						for (const auto & neededFile : cachedNeededFiles) {
+							this->addNeededFileForBuild(neededFile.first, neededFile.second);
+						}
+						for (const auto & resource : cachedResources) {
+							this->addResource(resource);
+						}
+						for (const auto & sourceFile : cachedSourceFiles) {
+							this->addSourceFile(sourceFile);
+						}
+						this->_needsAnotherPass = true;
+						this->addAlreadyImportedFile(path, cachedNodes, isNeeds);
+						resultNodes.insert(resultNodes.end(), cachedNodes.begin(), cachedNodes.end());
+						continue;
+					}
+				}
 				if (this->getVerbose() && instr->getVerbose()) {
 					std::cerr << (isNeeds ? "Extracting header of file " : "Importing ") << path.data() << "\n\n========================================\n\n";
 				}
@@ -133,6 +167,7 @@ void LILPreprocessor::processImportingInstr(const std::shared_ptr<LILRootNode> &
 				codeUnit->setNeedsConfigureDefaults(false);
 				codeUnit->setConstants(this->getConstants());
 				codeUnit->setConfiguration(this->_config);
+				codeUnit->setImportCache(this->_importCache);
 				if (isNeeds) {
 					codeUnit->setIsBeingImportedWithNeeds(true);
 					for (auto it = this->_alreadyImportedFilesNeeds.begin(); it != this->_alreadyImportedFilesNeeds.end(); ++it) {
@@ -152,19 +187,8 @@ void LILPreprocessor::processImportingInstr(const std::shared_ptr<LILRootNode> &
 				codeUnit->setDir(dir);
 				codeUnit->setSuffix(this->_suffix);
 				
-				std::string fpath = path.data();
-				if (this->_suffix.length() > 0) {
-					size_t extensionIndex = path.data().find_last_of(".");
-					
-					if (extensionIndex != std::string::npos) {
-						std::string spath = fpath.substr(0, extensionIndex) + "@" + this->_suffix.data() + fpath.substr(extensionIndex, fpath.length() - extensionIndex);
-						fpath = spath;
-					}
-				}
+				std::string fpath = this->_getSourcePath(path);
 				std::ifstream file(fpath, std::ios::in);
-				if (file.fail()) {
-					file = std::ifstream(path.data(), std::ios::in);
-				}
 				if (file.fail()) {
 					std::cerr << "\nERROR: Failed to read the file "+path.data()+"\n\n";
 					continue;
@@ -196,6 +220,10 @@ void LILPreprocessor::processImportingInstr(const std::shared_ptr<LILRootNode> &
 					for (const auto & resource : codeUnit->getResources()) {
 						this->addResource(resource);
 					}
+					this->addSourceFile(fpath);
+					for (const auto & sourceFile : codeUnit->getSourceFiles()) {
+						this->addSourceFile(sourceFile);
+					}
 				}
 				if (this->getVerbose() && instr->getVerbose()) {
 					std::cerr << "\nEnd of file " << path.data() << "\n\n========================================\n\n";
@@ -220,6 +248,15 @@ void LILPreprocessor::processImportingInstr(const std::shared_ptr<LILRootNode> &
 				if (isNeeds) {
 					this->addNeededFileForBuild(path, this->getVerbose() && instr->getVerbose());
 				}
+				if (this->_importCache) {
+					std::vector<std::pair<LILString, bool>> cachedNeededFiles = codeUnit->getNeededFilesForBuild();
+					if (isNeeds) {
+						cachedNeededFiles.push_back({ path, this->getVerbose() && instr->getVerbose() });
+					}
+					std::vector<LILString> sourceFiles = codeUnit->getSourceFiles();
+					sourceFiles.push_back(fpath);
+					this->_importCache->set(cacheKey, sourceFiles, newNodes, cachedNeededFiles, codeUnit->getResources());
+				}
 				resultNodes.insert(resultNodes.end(), newNodes.begin(), newNodes.end());
 			}
 		}
@@ -931,6 +968,18 @@ const std::vector<LILString> & LILPreprocessor::getResources() const
 	return this->_resources;
 }
 
+void LILPreprocessor::addSourceFile(const LILString & path)
+{
+	if (std::find(this->_sourceFiles.begin(), this->_sourceFiles.end(), path) == this->_sourceFiles.end()) {
+		this->_sourceFiles.push_back( path );
+	}
+}
+
+const std::vector<LILString> & LILPreprocessor::getSourceFiles() const
+{
+	return this->_sourceFiles;
+}
+
 bool LILPreprocessor::isAlreadyImported(const LILString & path, bool isNeeds)
 {
 	if (isNeeds) {
@@ -966,6 +1015,11 @@ void LILPreprocessor::setConfiguration(LILConfiguration * value)
 	this->_config = value;
 }
 
+void LILPreprocessor::setImportCache(LILImportCache * value)
+{
+	this->_importCache = value;
+}
+
 std::vector<LILString> LILPreprocessor::_resolveFilePaths(LILString argStr) const
 {
 	std::vector<LILString> ret;
@@ -1189,6 +1243,23 @@ void LILPreprocessor::_importNodeIfNeeded(std::vector<std::shared_ptr<LILNode>>
 	}
 }
 
+//files may have a variant for the current target, like audio@OS_MAC.lil, which is read instead
+std::string LILPreprocessor::_getSourcePath(const LILString & path) const
+{
+	std::string fpath = path.data();
+	if (this->_suffix.length() > 0) {
+		size_t extensionIndex = fpath.find_last_of(".");
+		if (extensionIndex != std::string::npos) {
+			std::string spath = fpath.substr(0, extensionIndex) + "@" + this->_suffix.data() + fpath.substr(extensionIndex, fpath.length() - extensionIndex);
+			std::ifstream file(spath, std::ios::in);
+			if (!file.fail()) {
+				return spath;
+			}
+		}
+	}
+	return fpath;
+}
+
 LILString LILPreprocessor::_getDir(LILString path) const
 {
 	std::string dir = path.data();
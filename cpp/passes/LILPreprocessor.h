@@ -51,6 +51,7 @@
 namespace LIL
 {
 	class LILConfiguration;
+	class LILImportCache;
 	class LILRootNode;
 	class LILPreprocessor : public LILVisitor
 	{
@@ -82,11 +83,14 @@ namespace LIL
 		const std::vector<std::pair<LILString, bool>> & getNeededFilesForBuild() const;
 		void addResource(const LILString & path);
 		const std::vector<LILString> & getResources() const;
+		void addSourceFile(const LILString & path);
+		const std::vector<LILString> & getSourceFiles() const;
 
 		void setConstants(std::vector<LILString> & values);
 		const std::vector<LILString> & getConstants() const;
 
 		void setConfiguration(LILConfiguration * value);
+		void setImportCache(LILImportCache * value);
 
 	private:
 		std::map<LILString, std::vector<std::shared_ptr<LILNode>>> _alreadyImportedFilesNeeds;
@@ -94,10 +98,12 @@ namespace LIL
 		std::vector<LILString> _constants;
 		std::vector<std::pair<LILString, bool>> _buildFiles;
 		std::vector<LILString> _resources;
+		std::vector<LILString> _sourceFiles;
 		std::vector<std::vector<std::shared_ptr<LILNode>>> _nodeBuffer;
 		LILString _dir;
 		LILString _suffix;
 		LILConfiguration * _config;
+		LILImportCache * _importCache;
 		bool _debugAST;
 		bool _needsAnotherPass;
 
@@ -105,6 +111,7 @@ namespace LIL
 		std::vector<std::string> _glob(const std::string& pattern) const;
 		void _importNodeIfNeeded(std::vector<std::shared_ptr<LILNode>> * newNodes, std::shared_ptr<LILNode> node, bool isExported) const;
 		LILString _getDir(LILString path) const;
+		std::string _getSourcePath(const LILString & path) const;
 
 		bool _processIfInstr(std::shared_ptr<LILExpression> value);
 		bool _processIfInstr(std::shared_ptr<LILUnaryExpression> value);
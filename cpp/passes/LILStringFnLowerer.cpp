@@ -28,6 +28,7 @@
 #include "LILNumberLiteral.h"
 #include "LILObjectDefinition.h"
 #include "LILObjectType.h"
+#include "LILPointerType.h"
 #include "LILPropertyName.h"
 #include "LILRootNode.h"
 #include "LILStringLiteral.h"
@@ -38,6 +39,10 @@
 #include "LILVarName.h"
 #include "LILVarDecl.h"
 
+//widest form of an i64 with sign, and the room @string.appendFloat starts with
+#define LIL_STRING_FN_INT_RESERVE 20
+#define LIL_STRING_FN_FLOAT_RESERVE 32
+
 using namespace LIL;
 
 LILStringFnLowerer::LILStringFnLowerer()
@@ -207,6 +212,7 @@ bool LILStringFnLowerer::_processStringFn(std::shared_ptr<LILStringFunction> val
 	auto fd = std::make_shared<LILFunctionDecl>();
 	fd->setSourceLocation(value->getSourceLocation());
 	auto fnName = "lil_string_fn_"+LILString::number((LILUnitI64)this->_count);
+	this->_count += 1;
 	fd->setName(fnName);
 	auto fnTy = std::make_shared<LILFunctionType>();
 	fnTy->setReturnType(LILObjectType::make("string"));
@@ -245,86 +251,96 @@ bool LILStringFnLowerer::_processStringFn(std::shared_ptr<LILStringFunction> val
 	retVd->setName("ret");
 	auto strTy = LILObjectType::make("string");
 	retVd->setType(strTy);
-	auto strLit = std::make_shared<LILStringLiteral>();
-	strLit->setSourceLocation(value->getSourceLocation());
+	auto emptyLit = std::make_shared<LILStringLiteral>();
+	emptyLit->setSourceLocation(value->getSourceLocation());
+	emptyLit->setValue("\"\"");
+	retVd->setInitVal(emptyLit);
+	fd->addEvaluable(retVd);
+
+	//collect the constant chunks, without their surrounding quotes
+	std::vector<LILString> chunks;
+	LILString quote = "\"";
 	auto startStr = value->getStartChunk();
-	//remove beginning quotes
 	if (startStr.substr(0, 1) == "\"" || startStr.substr(0, 1) == "'") {
-		strLit->setValue(startStr.substr(1, startStr.length() - 1));
+		quote = startStr.substr(0, 1);
+		chunks.push_back(startStr.substr(1, startStr.length() - 1));
 	} else {
-		strLit->setValue(startStr);
+		chunks.push_back(startStr);
 	}
-	retVd->setInitVal(strLit);
-
-	fd->addEvaluable(retVd);
-
-	const auto & midChunks = value->getMidChunks();
-	const auto & args = fnTy->getArguments();
-
-	i = 0;
-	for (auto node : value->getNodes()) {
-		auto vp = std::make_shared<LILValuePath>();
-		vp->setSourceLocation(value->getSourceLocation());
-		auto retVn = std::make_shared<LILVarName>();
-		retVn->setName("ret");
-		vp->addChild(retVn);
-		auto fc = std::make_shared<LILFunctionCall>();
-		fc->setFunctionCallType(FunctionCallTypeValuePath);
-		fc->setName("add");
-		vp->addChild(fc);
-		auto argVn = std::make_shared<LILVarName>();
-		argVn->setType(args.at(i)->getType()->clone());
-		argVn->setName("arg"+LILString::number((LILUnitI64)i));
-		fc->addArgument(argVn);
-		fd->addEvaluable(vp);
-
-		if (i < midChunks.size()) {
-			auto chunkLit = std::make_shared<LILStringLiteral>();
-			chunkLit->setValue(midChunks.at(i));
-			auto vp2 = std::make_shared<LILValuePath>();
-			vp2->setSourceLocation(value->getSourceLocation());
-			auto retVn2 = std::make_shared<LILVarName>();
-			retVn2->setSourceLocation(value->getSourceLocation());
-			retVn2->setName("ret");
-			vp2->addChild(retVn2);
-			auto fc2 = std::make_shared<LILFunctionCall>();
-			fc2->setFunctionCallType(FunctionCallTypeValuePath);
-			fc2->setSourceLocation(value->getSourceLocation());
-			fc2->setName("add");
-			vp2->addChild(fc2);
-			fc2->addArgument(chunkLit);
-			fd->addEvaluable(vp2);
-		}
-		i += 1;
+	for (const auto & midChunk : value->getMidChunks()) {
+		chunks.push_back(midChunk);
 	}
-
-	auto endChunkLit = std::make_shared<LILStringLiteral>();
-	endChunkLit->setSourceLocation(value->getSourceLocation());
 	auto endStr = value->getEndChunk();
-	//remove end quotes
 	auto endStrLen = endStr.length();
-	if (endStr.substr(endStrLen - 1, 1) == "\"" || endStr.substr(endStrLen - 1, 1) == "'") {
-		endChunkLit->setValue(endStr.substr(0, endStrLen - 1));
+	if (endStrLen > 0 && (endStr.substr(endStrLen - 1, 1) == "\"" || endStr.substr(endStrLen - 1, 1) == "'")) {
+		chunks.push_back(endStr.substr(0, endStrLen - 1));
 	} else {
-		endChunkLit->setValue(endStr);
-	}
-	auto vp3 = std::make_shared<LILValuePath>();
-	vp3->setSourceLocation(value->getSourceLocation());
-	auto retVn3 = std::make_shared<LILVarName>();
-	retVn3->setSourceLocation(value->getSourceLocation());
-	retVn3->setName("ret");
-	vp3->addChild(retVn3);
-	auto fc3 = std::make_shared<LILFunctionCall>();
-	fc3->setFunctionCallType(FunctionCallTypeValuePath);
-	fc3->setSourceLocation(value->getSourceLocation());
-	fc3->setName("add");
-	vp3->addChild(fc3);
-	fc3->addArgument(endChunkLit);
-	fd->addEvaluable(vp3);
+		chunks.push_back(endStr);
+	}
+
+	//reserve the total length once: the chunks are known now, strings know
+	//their length at runtime and numbers get room for their widest form
+	auto numTy = LILType::make("i64");
+	size_t constantLength = 0;
+	for (const auto & chunk : chunks) {
+		constantLength += chunk.replaceEscapes().length();
+	}
+	std::vector<std::shared_ptr<LILNode>> lengthNodes;
+	const auto & args = fnTy->getArguments();
+	for (size_t k = 0, l = args.size(); k<l; k+=1) {
+		auto argTy = args.at(k)->getType();
+		if (!argTy) {
+			continue;
+		}
+		if (argTy->isA(TypeTypePointer)) {
+			argTy = std::static_pointer_cast<LILPointerType>(argTy)->getArgument();
+		}
+		if (argTy && argTy->isA(TypeTypeObject) && argTy->getName() == "string") {
+			auto lengthVp = std::make_shared<LILValuePath>();
+			lengthVp->setSourceLocation(value->getSourceLocation());
+			auto argVn = std::make_shared<LILVarName>();
+			argVn->setName("arg"+LILString::number((LILUnitI64)k));
+			argVn->setType(args.at(k)->getType()->clone());
+			lengthVp->addChild(argVn);
+			auto lengthPn = std::make_shared<LILPropertyName>();
+			lengthPn->setName("length");
+			lengthVp->addChild(lengthPn);
+			lengthVp->setType(numTy->clone());
+			lengthNodes.push_back(lengthVp);
+		} else if (argTy && LILType::isFloatType(argTy.get())) {
+			constantLength += LIL_STRING_FN_FLOAT_RESERVE;
+		} else if (argTy && LILType::isIntegerType(argTy.get())) {
+			constantLength += LIL_STRING_FN_INT_RESERVE;
+		}
+	}
+	std::shared_ptr<LILNode> reserveArg;
+	auto constantLit = std::make_shared<LILNumberLiteral>();
+	constantLit->setValue(LILString::number((LILUnitI64)constantLength));
+	constantLit->setType(numTy->clone());
+	reserveArg = constantLit;
+	for (const auto & lengthNode : lengthNodes) {
+		auto sum = std::make_shared<LILExpression>();
+		sum->setExpressionType(ExpressionTypeSum);
+		sum->setType(numTy->clone());
+		sum->setLeft(reserveArg);
+		sum->setRight(lengthNode);
+		reserveArg = sum;
+	}
+	fd->addEvaluable(this->_makeRetCall("reserve", {reserveArg}, value->getSourceLocation()));
+
+	//then write every piece in place
+	for (size_t k = 0, l = chunks.size(); k<l; k+=1) {
+		this->_addChunk(fd, chunks.at(k), quote, value->getSourceLocation());
+		if (k < args.size()) {
+			auto argVn = std::make_shared<LILVarName>();
+			argVn->setType(args.at(k)->getType()->clone());
+			argVn->setName("arg"+LILString::number((LILUnitI64)k));
+			fd->addEvaluable(this->_makeRetCall("add", {argVn}, value->getSourceLocation()));
+		}
+	}
 
 	auto returnCall = std::make_shared<LILFlowControlCall>();
 	returnCall->setSourceLocation(value->getSourceLocation());
-	returnCall->setSourceLocation(value->getSourceLocation());
 	returnCall->setFlowControlCallType(FlowControlCallTypeReturn);
 	auto retVn = std::make_shared<LILVarName>();
 	retVn->setSourceLocation(value->getSourceLocation());
@@ -345,6 +361,44 @@ bool LILStringFnLowerer::_processStringFn(std::shared_ptr<LILStringFunction> val
 	return true;
 }
 
+std::shared_ptr<LILValuePath> LILStringFnLowerer::_makeRetCall(const LILString & name, std::vector<std::shared_ptr<LILNode>> && arguments, LILNode::SourceLocation loc) const
+{
+	auto vp = std::make_shared<LILValuePath>();
+	vp->setSourceLocation(loc);
+	auto retVn = std::make_shared<LILVarName>();
+	retVn->setSourceLocation(loc);
+	retVn->setName("ret");
+	retVn->setType(LILObjectType::make("string"));
+	vp->addChild(retVn);
+	auto fc = std::make_shared<LILFunctionCall>();
+	fc->setFunctionCallType(FunctionCallTypeValuePath);
+	fc->setSourceLocation(loc);
+	fc->setName(name);
+	for (auto arg : arguments) {
+		fc->addArgument(arg);
+	}
+	vp->addChild(fc);
+	return vp;
+}
+
+void LILStringFnLowerer::_addChunk(std::shared_ptr<LILFunctionDecl> fd, const LILString & chunk, const LILString & quote, LILNode::SourceLocation loc) const
+{
+	auto length = chunk.replaceEscapes().length();
+	if (length == 0) {
+		return;
+	}
+	//c string literals avoid building a temporary @string for each chunk
+	auto chunkLit = std::make_shared<LILStringLiteral>();
+	chunkLit->setSourceLocation(loc);
+	chunkLit->setIsCString(true);
+	//keep the quotes the chunk was written in, it can't hold those unescaped but it can hold backticks
+	chunkLit->setValue(quote+chunk+quote);
+	auto lengthLit = std::make_shared<LILNumberLiteral>();
+	lengthLit->setValue(LILString::number((LILUnitI64)length));
+	lengthLit->setType(LILType::make("i64"));
+	fd->addEvaluable(this->_makeRetCall("appendBytes", {chunkLit, lengthLit}, loc));
+}
+
 bool LILStringFnLowerer::_processStringFn(std::shared_ptr<LILExpression> value)
 {
 	auto left = value->getLeft();
@@ -33,6 +33,7 @@ namespace LIL
 	class LILStringFunction;
 	class LILUnaryExpression;
 	class LILValueList;
+	class LILValuePath;
 	class LILVarDecl;
 	
 	class LILStringFnLowerer : public LILVisitor
@@ -63,6 +64,8 @@ namespace LIL
 		bool _processStringFn(std::shared_ptr<LILValueList> value);
 		bool _processStringFn(std::shared_ptr<LILConversionDecl> value);
 		bool _processStringFn(std::shared_ptr<LILEnum> value);
+		std::shared_ptr<LILValuePath> _makeRetCall(const LILString & name, std::vector<std::shared_ptr<LILNode>> && arguments, LILNode::SourceLocation loc) const;
+		void _addChunk(std::shared_ptr<LILFunctionDecl> fd, const LILString & chunk, const LILString & quote, LILNode::SourceLocation loc) const;
 	};
 }
 
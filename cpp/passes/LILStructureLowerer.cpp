@@ -535,6 +535,9 @@ void LILStructureLowerer::_process(std::shared_ptr<LILFunctionDecl> value)
 
 	if (ty && ty->getTypeType() == TypeTypeFunction) {
 		auto fnTy = std::static_pointer_cast<LILFunctionType>(ty);
+		//every argument of multiple types gets specialized, in all combinations
+		std::vector<std::shared_ptr<LILNode>> loweredArgs;
+		std::vector<std::vector<std::shared_ptr<LILType>>> loweredTypes;
 		for (auto arg : fnTy->getArguments()) {
 			std::shared_ptr<LILType> tyArg;
 			if (arg->isA(NodeTypeType)) {
@@ -542,6 +545,9 @@ void LILStructureLowerer::_process(std::shared_ptr<LILFunctionDecl> value)
 			} else if (arg->isA(NodeTypeVarDecl)){
 				tyArg = arg->getType();
 			}
+			if (!tyArg) {
+				continue;
+			}
 
 			bool doLowering = false;
 			if ((tyArg->getTypeType() == TypeTypeMultiple) && !tyArg->getIsWeakType()) {
@@ -566,75 +572,97 @@ void LILStructureLowerer::_process(std::shared_ptr<LILFunctionDecl> value)
 				}
 			}
 			if (doLowering) {
-				auto newFd = std::make_shared<LILFunctionDecl>();
-				newFd->setIsExtern(value->getIsExtern());
-				newFd->setIsExported(value->getIsExported());
-
-				auto newFnType = fnTy->clone();
-				newFd->setType(newFnType);
-				
-				newFd->setHasMultipleImpls(true);
-				newFd->setName(value->getName());
-				newFd->hidden = value->hidden;
-
-				this->_nodeBuffer.back().push_back(newFd);
 				auto tyArgTypes = std::static_pointer_cast<LILMultipleType>(tyArg)->getTypes();
 				if (tyArg->getIsNullable()) {
 					tyArgTypes.push_back(LILType::make("null"));
 				}
-				for (auto argChild : tyArgTypes) {
-					auto newChildFd = std::make_shared<LILFunctionDecl>();
-					newChildFd->setIsExtern(value->getIsExtern());
-					newChildFd->setIsExported(value->getIsExported());
-
-					auto newChildFnType = std::make_shared<LILFunctionType>();
-					auto returnTy = fnTy->getReturnType();
-					if (returnTy) {
-						newChildFnType->setReturnType(returnTy);
+				loweredArgs.push_back(arg);
+				loweredTypes.push_back(tyArgTypes);
+			}
+		} //end for
+
+		if (loweredArgs.size() > 0) {
+			auto newFd = std::make_shared<LILFunctionDecl>();
+			newFd->setIsExtern(value->getIsExtern());
+			newFd->setIsExported(value->getIsExported());
+
+			auto newFnType = fnTy->clone();
+			newFd->setType(newFnType);
+			
+			newFd->setHasMultipleImpls(true);
+			newFd->setName(value->getName());
+			newFd->hidden = value->hidden;
+
+			this->_nodeBuffer.back().push_back(newFd);
+
+			//counts through the combinations like an odometer
+			std::vector<size_t> choice(loweredArgs.size(), 0);
+			bool done = false;
+			while (!done) {
+				auto newChildFd = std::make_shared<LILFunctionDecl>();
+				newChildFd->setIsExtern(value->getIsExtern());
+				newChildFd->setIsExported(value->getIsExported());
+
+				auto newChildFnType = std::make_shared<LILFunctionType>();
+				auto returnTy = fnTy->getReturnType();
+				if (returnTy) {
+					newChildFnType->setReturnType(returnTy);
+				}
+				newChildFd->setType(newChildFnType);
+				
+				std::vector<std::shared_ptr<LILNode>> newBody = value->getBody();
+				std::vector<std::shared_ptr<LILNode>> newArgs;
+				for (auto funArg : fnTy->getArguments()){
+					if (!funArg->isA(NodeTypeVarDecl)) {
+						continue;
 					}
-					newChildFd->setType(newChildFnType);
-					
-					std::vector<std::shared_ptr<LILNode>> newArgs;
-					for (auto funArg : fnTy->getArguments()){
-						if (!funArg->isA(NodeTypeVarDecl)) {
+					//disambiguate argument types
+					auto argClone = std::static_pointer_cast<LILVarDecl>(funArg)->clone();
+					for (size_t i=0, j=loweredArgs.size(); i<j; ++i) {
+						if (funArg != loweredArgs[i]) {
 							continue;
 						}
-						//disambiguate argument types
-						auto argClone = std::static_pointer_cast<LILVarDecl>(funArg)->clone();
-						auto funArgTy = funArg->getType();
-						if(funArg == arg){
-							argClone->setType(argChild);
-							newArgs.push_back(argClone);
-							
-							//resolve "if cast" blocks
-							std::vector<std::shared_ptr<LILNode>> newBody;
-							for (auto node : value->getBody()) {
-								auto newChildNodes = this->reduceIfCastBlocks(node, argClone->getName(), argChild);
-								for (auto child : newChildNodes) {
-									newBody.push_back(child);
-								}
+						auto argChild = loweredTypes[i][choice[i]];
+						argClone->setType(argChild);
+						
+						//resolve "if cast" blocks, the checks on this argument are known now
+						std::vector<std::shared_ptr<LILNode>> reducedBody;
+						for (auto node : newBody) {
+							auto newChildNodes = this->reduceIfCastBlocks(node, argClone->getName(), argChild);
+							for (auto child : newChildNodes) {
+								reducedBody.push_back(child);
 							}
-							newChildFd->setBody(newBody);
-						} else {
-							newArgs.push_back(argClone);
 						}
+						newBody = std::move(reducedBody);
 					}
-					
-					for (auto newArg : newArgs) {
-						newChildFnType->addArgument(newArg);
-						if (newArg->isA(NodeTypeVarDecl)) {
-							auto newArgVd = std::static_pointer_cast<LILVarDecl>(newArg);
-							newChildFd->setLocalVariable(newArgVd->getName(), newArgVd);
-						}
-						
+					newArgs.push_back(argClone);
+				}
+				newChildFd->setBody(newBody);
+				
+				for (auto newArg : newArgs) {
+					newChildFnType->addArgument(newArg);
+					if (newArg->isA(NodeTypeVarDecl)) {
+						auto newArgVd = std::static_pointer_cast<LILVarDecl>(newArg);
+						newChildFd->setLocalVariable(newArgVd->getName(), newArgVd);
 					}
-
-					newChildFd->setName(value->getName());
 					
-					newFd->addImpl(newChildFd);
-				} //end for
-			} //end if tyArg is multiple or not weak
-		} //end for
+				}
+
+				newChildFd->setName(value->getName());
+				
+				newFd->addImpl(newChildFd);
+
+				done = true;
+				for (size_t i=0, j=choice.size(); i<j; ++i) {
+					choice[i] += 1;
+					if (choice[i] < loweredTypes[i].size()) {
+						done = false;
+						break;
+					}
+					choice[i] = 0;
+				}
+			} //end while
+		} //end if any argument was lowered
 	} //end if ty isa function type
 	
 	this->processChildren(value->getBody());
@@ -682,7 +710,24 @@ std::vector<std::shared_ptr<LILNode>> LILStructureLowerer::reduceIfCastBlocks(st
 				}
 
 			}
-			break;
+
+			//checks nested in other blocks are resolved too
+			auto newFc = fc->clone();
+			std::vector<std::shared_ptr<LILNode>> newThen;
+			for (auto thenNode : fc->getThen()) {
+				auto childNodes = this->reduceIfCastBlocks(thenNode, argName, ty);
+				newThen.insert(newThen.end(), childNodes.begin(), childNodes.end());
+			}
+			newFc->setThen(std::move(newThen));
+			std::vector<std::shared_ptr<LILNode>> newElse;
+			for (auto elseNode : fc->getElse()) {
+				auto childNodes = this->reduceIfCastBlocks(elseNode, argName, ty);
+				newElse.insert(newElse.end(), childNodes.begin(), childNodes.end());
+			}
+			newFc->setElse(std::move(newElse));
+			std::vector<std::shared_ptr<LILNode>> ret;
+			ret.push_back(newFc);
+			return ret;
 		}
 
 		default:
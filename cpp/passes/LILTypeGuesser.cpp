@@ -16,6 +16,7 @@
 #include "LILAliasDecl.h"
 #include "LILNodeToString.h"
 #include "LILObjectType.h"
+#include "LILSIMDType.h"
 #include "LILStaticArrayType.h"
 #include "LILTypeDecl.h"
 #include "LILVarNode.h"
@@ -878,6 +879,9 @@ void LILTypeGuesser::_process(LILFunctionCall * value)
 		if (arg->getNodeType() == NodeTypeAssignment) {
 			auto asgmt = std::static_pointer_cast<LILAssignment>(arg);
 			ty = asgmt->getType();
+		} else if (arg->getNodeType() == NodeTypeNull) {
+			//null was given the type of the parameter when its own node was processed
+			ty = arg->getType();
 		} else {
 			ty = this->getNodeType(arg.get());
 		}
@@ -1037,6 +1041,45 @@ std::shared_ptr<LILType> LILTypeGuesser::recursiveFindTypeFromAncestors(LILNode
 						}
 						return nullptr;
 					}
+
+					case FunctionCallTypeSIMD:
+					{
+						//scalars take the element type of the vector, lane indices are i64
+						auto args = fc->getArguments();
+						size_t argIndex = 0;
+						for (size_t i=0, j=args.size(); i<j; ++i) {
+							if (args[i].get() == value) {
+								argIndex = i;
+							}
+						}
+						const auto & name = fc->getName();
+						if (name == "simdSplat" && argIndex == 1 && args[0]->isA(NodeTypeTypeDecl)) {
+							return std::static_pointer_cast<LILTypeDecl>(args[0])->getSrcType();
+						} else if (name == "simdWithLane" && argIndex == 2) {
+							return this->getNodeType(args[0].get());
+						} else if (
+							(name == "simdLane" && argIndex == 1)
+							|| (name == "simdWithLane" && argIndex == 1)
+							|| (name == "simdShuffle" && argIndex > 1)
+						) {
+							return LILType::make("i64");
+						}
+						return nullptr;
+					}
+
+					case FunctionCallTypeAtomic:
+					{
+						//the operands have the type that the address points to
+						auto args = fc->getArguments();
+						if (args.size() < 2 || args[0].get() == value) {
+							return nullptr;
+						}
+						auto addressTy = this->getNodeType(args[0].get());
+						if (addressTy && addressTy->isA(TypeTypePointer)) {
+							return std::static_pointer_cast<LILPointerType>(addressTy)->getArgument();
+						}
+						return nullptr;
+					}
 						
 					default:
 						break;
@@ -1193,6 +1236,10 @@ std::shared_ptr<LILFunctionType> LILTypeGuesser::findFnTypeForFunctionCall(LILFu
 		{
 			auto vp = fc->getSubject();
 			auto subjTy = this->findTypeForValuePath(vp.get());
+			//@self and pointers to objects call the methods of the pointee
+			if (subjTy && subjTy->isA(TypeTypePointer)) {
+				subjTy = std::static_pointer_cast<LILPointerType>(subjTy)->getArgument();
+			}
 			if (!subjTy || !subjTy->isA(TypeTypeObject)) {
 				std::cerr << "VAR PATH DOES NOT POINT TO OBJECT FAIL!!!!\n\n";
 				return nullptr;
@@ -1234,6 +1281,20 @@ void LILTypeGuesser::setTypeOnAncestorIfNeeded(LILNode * value, std::shared_ptr<
 				if (exp->isA(ExpressionTypeCast)) {
 					break;
 				}
+				//comparisons and logical operators are always bool, whatever their operands are
+				switch (exp->getExpressionType()) {
+					case ExpressionTypeSmallerComparison:
+					case ExpressionTypeSmallerOrEqualComparison:
+					case ExpressionTypeBiggerComparison:
+					case ExpressionTypeBiggerOrEqualComparison:
+					case ExpressionTypeEqualComparison:
+					case ExpressionTypeNotEqualComparison:
+					case ExpressionTypeLogicalOr:
+					case ExpressionTypeLogicalAnd:
+						return;
+					default:
+						break;
+				}
 				auto expTy = exp->getType();
 				if (!expTy || expTy->getIsWeakType()) {
 					exp->setType(ty);
@@ -1918,6 +1979,16 @@ std::shared_ptr<LILType> LILTypeGuesser::findReturnTypeForFunctionCall(LILFuncti
 		{
 			return LILType::make("i64");
 		}
+
+		case FunctionCallTypeSIMD:
+		{
+			return this->findTypeForSIMDCall(fc);
+		}
+
+		case FunctionCallTypeAtomic:
+		{
+			return this->findTypeForAtomicCall(fc);
+		}
 			
 		case FunctionCallTypePointerTo:
 		{
@@ -1946,6 +2017,88 @@ std::shared_ptr<LILType> LILTypeGuesser::findReturnTypeForFunctionCall(LILFuncti
 	return nullptr;
 }
 
+std::shared_ptr<LILType> LILTypeGuesser::findTypeForSIMDCall(LILFunctionCall * fc) const
+{
+	const auto & name = fc->getName();
+	const auto & args = fc->getArguments();
+	if (args.size() == 0 || name == "simdStore") {
+		return nullptr;
+	}
+	if (name == "simdSplat" || name == "simdLoad") {
+		const auto & firstArg = args.front();
+		if (!firstArg->isA(NodeTypeTypeDecl)) {
+			std::cerr << "FIRST ARG OF " << name.data() << " IS NOT A TYPE FAIL!!!!!!!!!!!!!!!!\n";
+			return nullptr;
+		}
+		return std::static_pointer_cast<LILTypeDecl>(firstArg)->getSrcType();
+	}
+	//the mask comes first in a select, the vectors after it
+	std::shared_ptr<LILType> vectorTy;
+	if (name == "simdSelect") {
+		if (args.size() < 2) {
+			return nullptr;
+		}
+		vectorTy = this->getNodeType(args[1].get());
+	} else {
+		vectorTy = this->getNodeType(args[0].get());
+	}
+	if (!vectorTy || !vectorTy->isA(TypeTypeSIMD)) {
+		return nullptr;
+	}
+	auto simdTy = std::static_pointer_cast<LILSIMDType>(vectorTy);
+	//lane indices are i64, even when the literal was typed after the var it is assigned to
+	for (size_t i=0, j=args.size(); i<j; ++i) {
+		if (
+			args[i]->isA(NodeTypeNumberLiteral)
+			&& (
+				((name == "simdLane" || name == "simdWithLane") && i == 1)
+				|| (name == "simdShuffle" && i > 1)
+			)
+		) {
+			std::static_pointer_cast<LILNumberLiteral>(args[i])->setType(LILType::make("i64"));
+		}
+	}
+	if (
+		name == "simdLane"
+		|| name == "simdReduceAdd"
+		|| name == "simdReduceMin"
+		|| name == "simdReduceMax"
+	) {
+		return simdTy->getType();
+	}
+	if (name == "simdShuffle") {
+		auto ret = simdTy->clone();
+		ret->setWidth(args.size() - 2);
+		return ret;
+	}
+	if (name == "simdEqual" || name == "simdLessThan" || name == "simdGreaterThan") {
+		//masks are integer vectors with all bits set in the true lanes
+		auto ret = simdTy->clone();
+		ret->setType(LILType::make("i" + LILString::number((LILUnitI32)simdTy->getType()->getBitWidth())));
+		return ret;
+	}
+	return vectorTy;
+}
+
+std::shared_ptr<LILType> LILTypeGuesser::findTypeForAtomicCall(LILFunctionCall * fc) const
+{
+	const auto & name = fc->getName();
+	const auto & args = fc->getArguments();
+	if (args.size() == 0 || name == "atomicStore" || name == "atomicFence") {
+		return nullptr;
+	}
+	if (name == "atomicCompareExchange") {
+		return LILType::make("bool");
+	}
+	//everything else gives back the value that was in memory before
+	auto addressTy = this->getNodeType(args[0].get());
+	if (!addressTy || !addressTy->isA(TypeTypePointer)) {
+		std::cerr << "FIRST ARG OF " << name.data() << " IS NOT A POINTER FAIL!!!!!!!!!!!!!!!!\n";
+		return nullptr;
+	}
+	return std::static_pointer_cast<LILPointerType>(addressTy)->getArgument();
+}
+
 std::shared_ptr<LILType> LILTypeGuesser::findTypeForVarName(LILVarName * name) const
 {
 	std::shared_ptr<LILNode> parent = name->getParentNode();
@@ -2280,6 +2433,12 @@ std::shared_ptr<LILType> LILTypeGuesser::findTypeForValuePath(LILValuePath * vp)
 						currentTy = retTy;
 						break;
 					}
+					else if (currentTy->isA(TypeTypePointer))
+					{
+						auto ptrTy = std::static_pointer_cast<LILPointerType>(currentTy);
+						currentTy = ptrTy->getArgument();
+						break;
+					}
 					else if (!currentTy->isA(TypeTypeStaticArray))
 					{
 						std::cerr << "FIELD TYPE IS NOT ARRAY TYPE FAIL!!!!\n";
@@ -2381,26 +2540,23 @@ std::shared_ptr<LILType> LILTypeGuesser::findTypeForSelectorChain(LILSelectorCha
 		}
 		
 	} else {
-		bool isLast = false;
-		std::vector<std::shared_ptr<LILRule>> currentSelection;
-
-		for (size_t i=1, j=selNodes.size(); i<j; ++i) {
-			isLast = i==j-1;
-			auto selNode = selNodes.at(i);
-			switch (selNode->getSelectorType()) {
-				case SelectorTypeRootSelector:
-				{
-					currentSelection = this->getRootNode()->getRules();
-					break;
+		//the emitter selects by the first name in the chain, so that is the element to look for
+		for (const auto & selNode : selNodes) {
+			if (selNode->getNodeType() != NodeTypeSimpleSelector) {
+				continue;
+			}
+			auto simpleSel = std::static_pointer_cast<LILSimpleSelector>(selNode);
+			for (const auto & ssNode : simpleSel->getNodes()) {
+				if (ssNode->getNodeType() != NodeTypeSelector || ssNode->getSelectorType() != SelectorTypeNameSelector) {
+					continue;
 				}
-					
-				case SelectorTypeNameSelector:
-				{
-					
-					break;
+				auto nameSel = std::static_pointer_cast<LILSelector>(ssNode);
+				for (const auto & element : this->_domBuilder->getDOM()->children) {
+					if (element->name == nameSel->getName()) {
+						return element->ty;
+					}
 				}
-				default:
-					break;
+				return nullptr;
 			}
 		}
 	}
@@ -2547,7 +2703,8 @@ std::shared_ptr<LILType> LILTypeGuesser::nullsToNullableTypes(std::shared_ptr<LI
 		case TypeTypeMultiple:
 		{
 			auto multiTy = std::static_pointer_cast<LILMultipleType>(ty);
-			bool isNullable = false;
+			//null may already have been taken out of the list and turned into the flag
+			bool isNullable = multiTy->getIsNullable();
 			std::vector<std::shared_ptr<LILType>> newTypes;
 			for (auto mTy : multiTy->getTypes()) {
 				if (mTy->getName() == "null") {
@@ -2560,6 +2717,7 @@ std::shared_ptr<LILType> LILTypeGuesser::nullsToNullableTypes(std::shared_ptr<LI
 				if (newTypes.size() == 1) {
 					auto theType = newTypes.front();
 					
+					//a single pointer needs no tag, null is never a valid address
 					if (theType->isA(TypeTypePointer) || (theType->getName() == "bool")) {
 						theType->setIsNullable(true);
 						ret = theType;
@@ -129,6 +129,8 @@ namespace LIL
 		void recursiveFindReturnTypes(std::vector<std::shared_ptr<LILType>> & returnTypes, std::shared_ptr<LILNode> eval) const;
 		void addTypeToReturnTypes(std::vector<std::shared_ptr<LILType>> & returnTypes, std::shared_ptr<LILType> ty) const;
 		std::shared_ptr<LILType> findReturnTypeForFunctionCall(LILFunctionCall * fc) const;
+		std::shared_ptr<LILType> findTypeForSIMDCall(LILFunctionCall * fc) const;
+		std::shared_ptr<LILType> findTypeForAtomicCall(LILFunctionCall * fc) const;
 		std::shared_ptr<LILType> findTypeForVarName(LILVarName * name) const;
 		std::shared_ptr<LILType> findTypeForValuePath(LILValuePath * vp) const;
 		std::shared_ptr<LILType> findTypeForPropertyName(LILPropertyName * name) const;
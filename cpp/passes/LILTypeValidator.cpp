@@ -17,16 +17,20 @@
 #include "LILClassDecl.h"
 #include "LILConversionDecl.h"
 #include "LILErrorMessage.h"
+#include "LILFlowControl.h"
 #include "LILFunctionCall.h"
 #include "LILFunctionDecl.h"
 #include "LILFunctionType.h"
 #include "LILMultipleType.h"
 #include "LILNodeToString.h"
+#include "LILNumberLiteral.h"
 #include "LILObjectType.h"
 #include "LILPointerType.h"
 #include "LILPropertyName.h"
+#include "LILSIMDType.h"
 #include "LILStaticArrayType.h"
 #include "LILTypeDecl.h"
+#include "LILUnaryExpression.h"
 #include "LILValuePath.h"
 #include "LILVarDecl.h"
 #include "LILVarName.h"
@@ -182,6 +186,13 @@ void LILTypeValidator::validate(std::shared_ptr<LILNode> node)
 			this->enterClassContext(cd);
 			break;
 		}
+
+		case NodeTypeFlowControl:
+		{
+			auto flowControl = std::static_pointer_cast<LILFlowControl>(node);
+			this->_validate(flowControl);
+			break;
+		}
 			
 		default:
 			break;
@@ -351,6 +362,171 @@ void LILTypeValidator::_validate(std::shared_ptr<LILFunctionCall> fc)
 		
 		this->_validateFCArguments(fnTy, fc, false, nullptr);
 	}
+	else if (fc->isA(FunctionCallTypeAtomic))
+	{
+		const auto & args = fc->getArguments();
+		if (fc->getName() == "atomicFence" || args.size() == 0) {
+			return;
+		}
+		auto addressTy = args[0]->getType();
+		if (!addressTy) {
+			return;
+		}
+		std::shared_ptr<LILType> valueTy;
+		if (addressTy->isA(TypeTypePointer)) {
+			valueTy = std::static_pointer_cast<LILPointerType>(addressTy)->getArgument();
+		}
+		//bool is not byte sized in LLVM, so it can't be accessed atomically
+		if (
+			!valueTy
+			|| valueTy->getName() == "bool"
+			|| !(LILType::isNumberType(valueTy.get()) || valueTy->isA(TypeTypePointer))
+		) {
+			LILErrorMessage ei;
+			ei.message =  "The first argument of "+fc->getName()+"() must be a pointer to a number or to a pointer";
+			LILNode::SourceLocation sl = args[0]->getSourceLocation();
+			ei.file = sl.file;
+			ei.line = sl.line;
+			ei.column = sl.column;
+			this->errors.push_back(ei);
+		}
+	}
+	else if (fc->isA(FunctionCallTypeSIMD) && fc->getName() == "simdShuffle")
+	{
+		const auto & args = fc->getArguments();
+		if (args.size() < 3) {
+			return;
+		}
+		auto vectorTy = args[0]->getType();
+		if (!vectorTy || !vectorTy->isA(TypeTypeSIMD)) {
+			return;
+		}
+		//the lanes index into both vectors, the second one starting after the last lane of the first
+		long long laneCount = std::static_pointer_cast<LILSIMDType>(vectorTy)->getWidth() * 2;
+		for (size_t i=2, j=args.size(); i<j; ++i) {
+			const auto & laneNode = args[i];
+			if (!laneNode->isA(NodeTypeNumberLiteral)) {
+				continue;
+			}
+			long long lane = std::static_pointer_cast<LILNumberLiteral>(laneNode)->getValue().toLongLong();
+			if (lane < 0 || lane >= laneCount) {
+				LILErrorMessage ei;
+				ei.message =  "The lane " + LILString::number((LILUnitI64)lane) + " in call to simdShuffle() is out of range, it must be less than " + LILString::number((LILUnitI64)laneCount);
+				LILNode::SourceLocation sl = laneNode->getSourceLocation();
+				ei.file = sl.file;
+				ei.line = sl.line;
+				ei.column = sl.column;
+				this->errors.push_back(ei);
+			}
+		}
+	}
+}
+
+void LILTypeValidator::_validate(std::shared_ptr<LILFlowControl> value)
+{
+	//the emitter reads the size and the data pointer of the subject once, before the loop,
+	//which is only right if the body leaves the subject alone. Otherwise the loop keeps
+	//going through value() and reads the size again on every iteration
+	if (!value->getIteratesData()) {
+		return;
+	}
+	const auto & subject = value->getSubject();
+	if (!subject || !subject->getType()) {
+		return;
+	}
+	auto cd = this->findClassWithName(subject->getType()->getName());
+	if (!cd) {
+		return;
+	}
+	LILString subjectStr = LILNodeToString::stringify(subject.get());
+	for (const auto & node : value->getThen()) {
+		if (this->_changesIterationSubject(node.get(), subjectStr, cd.get())) {
+			value->setIteratesData(false);
+			return;
+		}
+	}
+}
+
+bool LILTypeValidator::_changesIterationSubject(LILNode * node, const LILString & subjectStr, LILClassDecl * cd) const
+{
+	if (node->isA(NodeTypeFunctionCall)) {
+		auto fc = static_cast<LILFunctionCall *>(node);
+		auto fcSubject = fc->isA(FunctionCallTypeValuePath) ? fc->getSubject() : nullptr;
+		if (fcSubject && LILNodeToString::stringify(fcSubject.get()) == subjectStr) {
+			auto meth = cd->getMethodNamed(fc->getName());
+			std::vector<LILFunctionDecl *> visited;
+			if (meth && meth->isA(NodeTypeFunctionDecl) && this->_changesSelf(static_cast<LILFunctionDecl *>(meth.get()), cd, visited)) {
+				return true;
+			}
+		}
+	} else if (node->isA(NodeTypeAssignment) || node->isA(NodeTypeUnaryExpression)) {
+		std::shared_ptr<LILNode> target;
+		if (node->isA(NodeTypeAssignment)) {
+			target = static_cast<LILAssignment *>(node)->getSubject();
+		} else {
+			target = static_cast<LILUnaryExpression *>(node)->getSubject();
+		}
+		if (target) {
+			LILString targetStr = LILNodeToString::stringify(target.get());
+			if (targetStr == subjectStr || targetStr.data().substr(0, subjectStr.length() + 1) == subjectStr.data() + ".") {
+				return true;
+			}
+		}
+	}
+	for (const auto & child : node->getChildNodes()) {
+		if (this->_changesIterationSubject(child.get(), subjectStr, cd)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//whether the method assigns to a field of @self, directly or through another method of the class
+bool LILTypeValidator::_changesSelf(LILFunctionDecl * fd, LILClassDecl * cd, std::vector<LILFunctionDecl *> & visited) const
+{
+	if (std::find(visited.begin(), visited.end(), fd) != visited.end()) {
+		return false;
+	}
+	visited.push_back(fd);
+	for (const auto & node : fd->getBody()) {
+		if (this->_changesSelf(node.get(), cd, visited)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool LILTypeValidator::_changesSelf(LILNode * node, LILClassDecl * cd, std::vector<LILFunctionDecl *> & visited) const
+{
+	std::shared_ptr<LILNode> target;
+	if (node->isA(NodeTypeAssignment)) {
+		target = static_cast<LILAssignment *>(node)->getSubject();
+	} else if (node->isA(NodeTypeUnaryExpression)) {
+		target = static_cast<LILUnaryExpression *>(node)->getSubject();
+	} else if (node->isA(NodeTypeFunctionCall)) {
+		auto fc = static_cast<LILFunctionCall *>(node);
+		if (fc->isA(FunctionCallTypeValuePath)) {
+			auto fcSubject = fc->getSubject();
+			if (fcSubject && fcSubject->getNodes().size() == 1 && fcSubject->getNodes().front()->isA(SelectorTypeSelfSelector)) {
+				auto meth = cd->getMethodNamed(fc->getName());
+				if (meth && meth->isA(NodeTypeFunctionDecl) && this->_changesSelf(static_cast<LILFunctionDecl *>(meth.get()), cd, visited)) {
+					return true;
+				}
+			}
+		}
+	}
+	if (target && target->isA(NodeTypeValuePath)) {
+		const auto & targetNodes = std::static_pointer_cast<LILValuePath>(target)->getNodes();
+		if (targetNodes.size() > 1 && targetNodes.front()->isA(SelectorTypeSelfSelector)) {
+			return true;
+		}
+	}
+	for (const auto & child : node->getChildNodes()) {
+		if (this->_changesSelf(child.get(), cd, visited)) {
+			return true;
+		}
+	}
+	return false;
 }
 
 void LILTypeValidator::_validateFCArguments(std::shared_ptr<LILFunctionType> fnTy, std::shared_ptr<LILFunctionCall> fc, bool isMethod, std::shared_ptr<LILValuePath> vp)
@@ -502,6 +678,9 @@ void LILTypeValidator::_validateFCArguments(std::shared_ptr<LILFunctionType> fnT
 						}
 					}
 					found = allFound;
+					if (found) {
+						i += 1;
+					}
 				} else {
 					bool wasNullable = false;
 					if (fcArgTy->getIsNullable() && mtTy->getIsNullable()) {
@@ -777,6 +956,12 @@ void LILTypeValidator::_validate(std::shared_ptr<LILObjectDefinition> od)
 							currentTy = retTy;
 							break;
 						}
+						else if (currentTy->isA(TypeTypePointer))
+						{
+							auto ptrTy = std::static_pointer_cast<LILPointerType>(currentTy);
+							currentTy = ptrTy->getArgument();
+							break;
+						}
 						else if (!currentTy->isA(TypeTypeStaticArray))
 						{
 							std::cerr << "FIELD TYPE IS NOT ARRAY TYPE FAIL!!!!\n";
@@ -30,6 +30,8 @@
 
 namespace LIL
 {
+	class LILFlowControl;
+
 	class LILTypeValidator : public LILVisitor
 	{
 	public:
@@ -47,6 +49,7 @@ namespace LIL
 		bool _validateField(std::shared_ptr<LILType> vdTy, std::shared_ptr<LILType> asTy);
 		void _validate(std::shared_ptr<LILVarDecl> vd);
 		void _validate(std::shared_ptr<LILVarName> vn);
+		void _validate(std::shared_ptr<LILFlowControl> value);
 		inline void validateChildren(const std::vector<std::shared_ptr<LILNode>> & children);
 
 		std::shared_ptr<LILClassDecl> getClassContext() const;
@@ -57,6 +60,9 @@ namespace LIL
 		std::vector<std::shared_ptr<LILClassDecl>> _classContext;
 
 		bool _isCustomType(const std::shared_ptr<LILType> & ty) const;
+		bool _changesIterationSubject(LILNode * node, const LILString & subjectStr, LILClassDecl * cd) const;
+		bool _changesSelf(LILFunctionDecl * fd, LILClassDecl * cd, std::vector<LILFunctionDecl *> & visited) const;
+		bool _changesSelf(LILNode * node, LILClassDecl * cd, std::vector<LILFunctionDecl *> & visited) const;
 	};
 }
 
@@ -21,6 +21,8 @@
 #include "LILDocumentationWriter.h"
 #include "LILDocumentationTmplManager.h"
 #include "LILErrorMessage.h"
+#include "LILImportCache.h"
+#include "LILJIT.h"
 #include "LILNumberLiteral.h"
 #include "LILOutputEmitter.h"
 #include "LILPlatformSupport.h"
@@ -34,6 +36,13 @@
 
 #include <sys/stat.h>
 #include <array>
+#include <thread>
+
+#if defined(LIL_HAS_LLD)
+#include "lld/Common/CommonLinkerContext.h"
+#include "lld/Common/Driver.h"
+#include "llvm/Support/raw_ostream.h"
+#endif
 
 using namespace LIL;
 
@@ -42,7 +51,9 @@ extern void LILPrintErrors(const std::vector<LILErrorMessage> & errors, const LI
 LILBuildManager::LILBuildManager()
 : _codeUnit(nullptr)
 , _config(std::make_unique<LILConfiguration>())
+, _importCache(nullptr)
 , _hasErrors(false)
+, _exitCode(0)
 , _debug(false)
 , _verbose(false)
 , _noConfigureDefaults(false)
@@ -58,6 +69,39 @@ inline bool file_exists (const std::string & name) {
 	return (stat (name.c_str(), &buffer) == 0);
 }
 
+//splits a linker flag from the configuration into separate arguments, honoring quotes,
+//so that things like "-framework Cocoa" or '"%buildPath/file.o"' can be passed without a shell
+void LIL_splitLinkerFlag(const std::string & flag, std::vector<std::string> & args)
+{
+	std::string current;
+	bool hasCurrent = false;
+	char quote = 0;
+	for (char c : flag) {
+		if (quote != 0) {
+			if (c == quote) {
+				quote = 0;
+			} else {
+				current += c;
+			}
+		} else if (c == '"' || c == '\'') {
+			quote = c;
+			hasCurrent = true;
+		} else if (c == ' ' || c == '\t' || c == '\n') {
+			if (hasCurrent) {
+				args.push_back(current);
+				current.clear();
+				hasCurrent = false;
+			}
+		} else {
+			current += c;
+			hasCurrent = true;
+		}
+	}
+	if (hasCurrent) {
+		args.push_back(current);
+	}
+}
+
 LILBuildManager::~LILBuildManager()
 {
 	
@@ -267,6 +311,21 @@ void LILBuildManager::build()
 		needsDocs = this->_config->getConfigBool("documentation");
 	}
 
+	//0 means one codegen thread per core
+	long int codegenThreadsConfig = this->_config->getConfigInt("codegenThreads");
+	unsigned codegenThreads = codegenThreadsConfig > 0 ? static_cast<unsigned>(codegenThreadsConfig) : std::max(1u, std::thread::hardware_concurrency());
+	bool loopRemarks = this->_config->getConfigBool("loopRemarks");
+
+	//in jit mode the code is run in-process instead of being written to disk, linked and spawned
+	bool useJIT = this->_config->getConfigBool("jit") && !needsDocs;
+	if (useJIT && isApp) {
+		std::cerr << "Warning: jit mode is not available for apps, building normally.\n";
+		useJIT = false;
+	}
+	if (useJIT && (this->_compileToS || this->_config->getConfigBool("printOnly"))) {
+		useJIT = false;
+	}
+
 	if (needsCompile || needsDocs) {
 		std::string filePath;
 		if (this->_file.data().substr(0, 1) == "/") {
@@ -319,6 +378,10 @@ void LILBuildManager::build()
 		mainCodeUnit->setImports(imports);
 		mainCodeUnit->setArguments(this->_arguments);
 		mainCodeUnit->setConfiguration(this->_config.get());
+		if (this->_importCache) {
+			this->_importCache->setConfigKey(this->_config->getFingerprint());
+			mainCodeUnit->setImportCache(this->_importCache);
+		}
 		
 		mainCodeUnit->setFile(this->_file);
 		std::vector<std::shared_ptr<LILNode>> emptyVect;
@@ -337,6 +400,9 @@ void LILBuildManager::build()
 			return;
 		}
 		
+		std::unique_ptr<LILJIT> jit;
+		//extra object files from splitting the main module for parallel codegen
+		std::vector<std::string> partitionFiles;
 		if (needsDocs)
 		{
 			std::string oDir = buildPath+"/docs";
@@ -396,17 +462,41 @@ void LILBuildManager::build()
 				outFile.close();
 			}
 		}
+		else if (useJIT)
+		{
+			jit = std::make_unique<LILJIT>();
+			jit->setVerbose(this->_verbose);
+			if (!jit->initialize()) {
+				this->_hasErrors = true;
+				return;
+			}
+			std::unique_ptr<LILOutputEmitter> outEmitter = std::make_unique<LILOutputEmitter>();
+			outEmitter->setVerbose(this->_verbose);
+			outEmitter->setDebugIREmitter(this->_debug);
+			outEmitter->setLoopRemarks(loopRemarks);
+			outEmitter->setInFile(this->_file);
+			outEmitter->setCPU(this->_config->getConfigString("cpu"));
+			outEmitter->setVendor(this->_config->getConfigString("vendor"));
+			outEmitter->prepare();
+			outEmitter->setDOM(mainCodeUnit->getDOM());
+			if (!outEmitter->compileToJIT(mainCodeUnit->getRootNode(), jit.get())) {
+				this->_hasErrors = true;
+				return;
+			}
+		}
 		else
 		{
 			std::unique_ptr<LILOutputEmitter> outEmitter = std::make_unique<LILOutputEmitter>();
 			outEmitter->setVerbose(this->_verbose);
 			outEmitter->setDebugIREmitter(this->_debug);
+			outEmitter->setLoopRemarks(loopRemarks);
 			LILString oFile = outName;
 			oFile += (this->_compileToS ? ".s" : this->_config->getConfigString("objExt") );
 
 			outEmitter->setInFile(this->_file);
 			outEmitter->setOutFile(oFile);
 			outEmitter->setDir(buildPath);
+			outEmitter->setCodegenThreads(codegenThreads);
 
 			outEmitter->setCPU(this->_config->getConfigString("cpu"));
 			outEmitter->setVendor(this->_config->getConfigString("vendor"));
@@ -422,12 +512,14 @@ void LILBuildManager::build()
 					outEmitter->compileToS(mainCodeUnit->getRootNode());
 				} else {
 					outEmitter->compileToO(mainCodeUnit->getRootNode());
+					const auto & outputFiles = outEmitter->getOutputFiles();
+					partitionFiles.insert(partitionFiles.end(), outputFiles.begin() + 1, outputFiles.end());
 				}
 			}
 		}
 		
 		if (!this->_config->getConfigBool("singleFile")) {
-			std::vector<std::string> linkFiles;
+			std::vector<std::string> linkFiles = partitionFiles;
 
 			std::string stdLilOutputFolder = buildPath+"/std";
 			std::string stdLilDir = this->_config->getConfigString("stdLilDir");
@@ -476,7 +568,9 @@ void LILBuildManager::build()
 				std::string oFile = fileName+this->_config->getConfigString("objExt");
 				std::string oDir = buildPath+"/"+fileDir;
 
-				if (isStdLilDir && !this->_config->getConfigBool("rebuildStdLil")) {
+				//cached objects can't be used in jit mode, because the JIT runs the global
+				//initializers of IR modules only
+				if (isStdLilDir && !useJIT && !this->_config->getConfigBool("rebuildStdLil")) {
 					std::string oPath = oDir+"/"+oFile;
 					std::ifstream outputFile(oPath, std::ios::in);
 					if (!outputFile.fail()) {
@@ -484,6 +578,9 @@ void LILBuildManager::build()
 							std::cerr << "Skipping " << oPath << " because it already exists\n";
 						}
 						linkFiles.push_back(oPath);
+						for (const auto & partPath : LILOutputEmitter::getExistingPartitions(oPath)) {
+							linkFiles.push_back(partPath);
+						}
 						continue;
 					}
 				}
@@ -527,6 +624,7 @@ void LILBuildManager::build()
 				codeUnit->setConstants(constants);
 				codeUnit->setArguments(this->_arguments);
 				codeUnit->setConfiguration(this->_config.get());
+				codeUnit->setImportCache(this->_importCache);
 				codeUnit->setSuffix(this->_config->getConfigString("suffix"));
 				
 				codeUnit->setFile(fileNameExt);
@@ -544,13 +642,29 @@ void LILBuildManager::build()
 				
 				codeUnit->run();
 
-				if (!needsDocs) {
+				if (useJIT) {
+					std::unique_ptr<LILOutputEmitter> outEmitter = std::make_unique<LILOutputEmitter>();
+					outEmitter->setVerbose(fileIsVerbose);
+					outEmitter->setDebugIREmitter(this->_debug);
+					outEmitter->setLoopRemarks(loopRemarks);
+					outEmitter->setInFile(fileNameExt);
+					outEmitter->setCPU(this->_config->getConfigString("cpu"));
+					outEmitter->setVendor(this->_config->getConfigString("vendor"));
+					outEmitter->prepare();
+					outEmitter->setDOM(codeUnit->getDOM());
+					if (!outEmitter->compileToJIT(codeUnit->getRootNode(), jit.get())) {
+						this->_hasErrors = true;
+						return;
+					}
+				} else if (!needsDocs) {
 					std::unique_ptr<LILOutputEmitter> outEmitter = std::make_unique<LILOutputEmitter>();
 					outEmitter->setVerbose(fileIsVerbose);
 					outEmitter->setDebugIREmitter(this->_debug);
+					outEmitter->setLoopRemarks(loopRemarks);
 					outEmitter->setInFile(fileNameExt);
 					outEmitter->setOutFile(oFile);
 					outEmitter->setDir(oDir);
+					outEmitter->setCodegenThreads(codegenThreads);
 					outEmitter->setCPU(this->_config->getConfigString("cpu"));
 					outEmitter->setVendor(this->_config->getConfigString("vendor"));
 
@@ -568,6 +682,10 @@ void LILBuildManager::build()
 					std::string linkFileStr = oDir + "/" + oFile;
 					if (std::find(linkFiles.begin(), linkFiles.end(), linkFileStr) == linkFiles.end()) {
 						linkFiles.push_back(linkFileStr);
+						const auto & outputFiles = outEmitter->getOutputFiles();
+						for (size_t i = 1; i < outputFiles.size(); ++i) {
+							linkFiles.push_back(outputFiles[i]);
+						}
 					}
 				}
 			} //for
@@ -575,6 +693,73 @@ void LILBuildManager::build()
 			if (needsDocs) {
 				return;
 			}
+
+			if (useJIT) {
+				if (this->_verbose) {
+					std::cerr << "\n============================" << "\n";
+					std::cerr << "====== RUNNING (JIT) =======" << "\n";
+					std::cerr << "============================" << "\n";
+				}
+				//what the system linker would get: object files and archives are loaded
+				//into the JIT, shared libraries through the dynamic loader
+				std::vector<std::string> jitInputs = linkFiles;
+				for (const auto & linkerFlag : this->_config->getConfigItems(isApp ? "linkerFlagsApp" : "linkerFlags")) {
+					auto tmp = this->_config->extractString(linkerFlag);
+					if (tmp.length() > 0) {
+						LIL_splitLinkerFlag(tmp, jitInputs);
+					}
+				}
+				for (const auto & input : jitInputs) {
+					std::string ext;
+					size_t dotIndex = input.find_last_of(".");
+					if (dotIndex != std::string::npos && input.find_first_of("/", dotIndex) == std::string::npos) {
+						ext = input.substr(dotIndex);
+					}
+					bool success = true;
+					if (ext == ".o" || ext == ".obj") {
+						success = jit->addObjectFile(input);
+					} else if (ext == ".a" || ext == ".lib") {
+						success = jit->addArchive(input);
+					} else if (ext == ".so" || ext == ".dylib" || ext == ".dll") {
+						success = jit->addDynamicLibrary(input);
+					} else if (input.substr(0, 2) == "-l") {
+						std::string libName = input.substr(2);
+						//these are already part of the compiler process
+						if (libName == "c" || libName == "m" || libName == "pthread" || libName == "dl") {
+							continue;
+						}
+#if defined(__APPLE__)
+						success = jit->addDynamicLibrary("lib" + libName + ".dylib");
+#elif defined(_WIN32)
+						success = jit->addDynamicLibrary(libName + ".dll");
+#else
+						success = jit->addDynamicLibrary("lib" + libName + ".so");
+#endif
+					} else if (this->_verbose) {
+						std::cerr << "Ignoring linker argument " << input << " in jit mode\n";
+					}
+					if (!success) {
+						LILErrorMessage ei;
+						ei.message = "\nERROR: Could not load " + input + " into the JIT";
+						ei.file = this->_file.data();
+						ei.line = 0;
+						ei.column = 0;
+						this->_errors.push_back(ei);
+						this->_hasErrors = true;
+
+						LILPrintErrors(this->_errors, "");
+						return;
+					}
+				}
+
+				std::vector<std::string> programArgs;
+				programArgs.push_back(outName);
+				this->_exitCode = jit->runMain(programArgs);
+				if (this->_verbose) {
+					std::cerr << "\nProgram exited with code " << this->_exitCode << "\n";
+				}
+				return;
+			}
 			
 			std::string outFileName = buildPath + "/" + out;
 			
@@ -615,7 +800,36 @@ void LILBuildManager::build()
 				}
 			}
 			
-			if (this->_config->getConfigBool("link")) {
+			if (this->_config->getConfigBool("link") && this->_config->getConfigString("linker") == "lld-inproc") {
+				std::vector<std::string> linkArgs;
+				linkArgs.push_back(buildPath + "/" + outName + objExt);
+				for (const auto & linkFile : linkFiles) {
+					linkArgs.push_back(linkFile);
+				}
+				for (const auto & linkerFlag : this->_config->getConfigItems(isApp ? "linkerFlagsApp" : "linkerFlags")) {
+					auto tmp = this->_config->extractString(linkerFlag);
+					if (tmp.length() > 0) {
+						LIL_splitLinkerFlag(tmp, linkArgs);
+					}
+				}
+				linkArgs.push_back("-o");
+				linkArgs.push_back(outFileName);
+
+				if (this->_verbose) {
+					std::cerr << "\n============================" << "\n";
+					std::cerr << "===== LINKING (LLD) ========" << "\n";
+					std::cerr << "============================" << "\n";
+					for (const auto & arg : linkArgs) {
+						std::cerr << arg << " ";
+					}
+					std::cerr << "\n\n";
+				}
+				if (!this->_linkInProcess(linkArgs, outFileName)) {
+					LILPrintErrors(this->_errors, "");
+					std::cerr << "\nThere was an error while linking. Exiting.\n\n";
+					return;
+				}
+			} else if (this->_config->getConfigBool("link")) {
 #if defined(_WIN32)
 				std::string linkCommand = "LINK \"" + buildPath + "/" + outName + objExt + "\"";
 #else
@@ -787,11 +1001,86 @@ void LILBuildManager::build()
 	}
 }
 
+bool LILBuildManager::_linkInProcess(const std::vector<std::string> & args, const std::string & outFileName)
+{
+#if defined(LIL_HAS_LLD)
+	std::vector<const char *> lldArgs;
+#if defined(__APPLE__)
+	lldArgs.push_back("ld64.lld");
+#else
+	lldArgs.push_back("ld.lld");
+#endif
+	for (const auto & arg : args) {
+		lldArgs.push_back(arg.c_str());
+	}
+
+	std::string lldOut;
+	std::string lldErr;
+	llvm::raw_string_ostream lldOutStream(lldOut);
+	llvm::raw_string_ostream lldErrStream(lldErr);
+#if defined(__APPLE__)
+	bool success = lld::macho::link(lldArgs, lldOutStream, lldErrStream, false, false);
+#else
+	bool success = lld::elf::link(lldArgs, lldOutStream, lldErrStream, false, false);
+#endif
+	//free the global linker state so that we can link again in the same process
+	lld::CommonLinkerContext::destroy();
+	lldOutStream.flush();
+	lldErrStream.flush();
+
+	if (lldOut.length() > 0) {
+		std::cerr << lldOut;
+	}
+	//every line of the linker's diagnostics becomes its own error
+	std::stringstream errStream(lldErr);
+	std::string line;
+	while (std::getline(errStream, line)) {
+		if (line.length() == 0) {
+			continue;
+		}
+		LILErrorMessage ei;
+		ei.message = "\nLINKER: " + line;
+		ei.file = outFileName;
+		ei.line = 0;
+		ei.column = 0;
+		this->_errors.push_back(ei);
+	}
+	if (!success || !file_exists(outFileName)) {
+		if (this->_errors.size() == 0) {
+			LILErrorMessage ei;
+			ei.message = "\nERROR: The linker failed to produce "+outFileName;
+			ei.file = outFileName;
+			ei.line = 0;
+			ei.column = 0;
+			this->_errors.push_back(ei);
+		}
+		this->_hasErrors = true;
+		return false;
+	}
+	return true;
+#else
+	(void)args;
+	LILErrorMessage ei;
+	ei.message = "\nERROR: The lld-inproc linker was requested, but this compiler was built without LLD (define LIL_HAS_LLD and link against lldELF/lldMachO/lldCommon)";
+	ei.file = outFileName;
+	ei.line = 0;
+	ei.column = 0;
+	this->_errors.push_back(ei);
+	this->_hasErrors = true;
+	return false;
+#endif
+}
+
 bool LILBuildManager::hasErrors() const
 {
 	return this->_hasErrors;
 }
 
+int LILBuildManager::getExitCode() const
+{
+	return this->_exitCode;
+}
+
 void LILBuildManager::setDirectory(LILString value)
 {
 	this->_directory = value;
@@ -841,3 +1130,8 @@ void LILBuildManager::setArguments(std::vector<LILString> &&args)
 {
 	this->_arguments = std::move(args);
 }
+
+void LILBuildManager::setImportCache(LILImportCache * value)
+{
+	this->_importCache = value;
+}
@@ -21,6 +21,7 @@ namespace LIL {
 	class LILCodeUnit;
 	class LILConfiguration;
 	class LILErrorMessage;
+	class LILImportCache;
 	class LILRule;
 	
 	class LILBuildManager
@@ -32,6 +33,7 @@ namespace LIL {
 		void configure();
 		void build();
 		bool hasErrors() const;
+		int getExitCode() const;
 		void setDirectory(LILString value);
 		void setFile(LILString value);
 		void setCompilerDir(LILString value);
@@ -41,16 +43,21 @@ namespace LIL {
 		void setDebugConfigureDefaults(bool value);
 		void setWarningLevel(int value);
 		void setArguments(std::vector<LILString> && args);
+		void setImportCache(LILImportCache * value);
 	private:
+		bool _linkInProcess(const std::vector<std::string> & args, const std::string & outFileName);
+
 		std::unique_ptr<LILConfiguration> _config;
 		std::unique_ptr<LILCodeUnit> _codeUnit;
 		std::vector<LILErrorMessage> _errors;
 		std::vector<LILString> _arguments;
+		LILImportCache * _importCache;
 		LILString _directory;
 		LILString _file;
 		LILString _compilerDir;
 		LILString _minOSVersion;
 		bool _hasErrors;
+		int _exitCode;
 		bool _debug;
 		bool _verbose;
 		bool _noConfigureDefaults;
@@ -24,6 +24,7 @@
 #include "LILConfigGetter.h"
 #include "LILConversionInserter.h"
 #include "LILConstantFolder.h"
+#include "LILDeadCodeEliminator.h"
 #include "LILEnumLowerer.h"
 #include "LILFieldSorter.h"
 #include "LILForLowerer.h"
@@ -58,6 +59,7 @@ namespace LIL
 		, pm(std::make_unique<LILPassManager>())
 		, isMain(false)
 		, config(nullptr)
+		, importCache(nullptr)
 		, verbose(false)
 		, debugStdLil(false)
 		, importStdLil(false)
@@ -82,11 +84,13 @@ namespace LIL
 		std::vector<LILString> arguments;
 		std::vector<std::pair<LILString, bool>> neededFiles;
 		std::vector<LILString> resources;
+		std::vector<LILString> sourceFiles;
 		std::vector<LILString> constants;
 		std::vector<LILString> imports;
 		std::shared_ptr<LILElement> dom;
 
 		LILConfiguration * config;
+		LILImportCache * importCache;
 		bool verbose;
 		bool debugStdLil;
 		bool importStdLil;
@@ -224,6 +228,11 @@ void LILCodeUnit::setConfiguration(LILConfiguration * value)
 	d->config = value;
 }
 
+void LILCodeUnit::setImportCache(LILImportCache * value)
+{
+	d->importCache = value;
+}
+
 void LILCodeUnit::run()
 {
 	bool verbose = d->verbose;
@@ -392,6 +401,7 @@ void LILCodeUnit::runPasses()
 	preprocessor->setSuffix(d->suffix);
 	preprocessor->setConstants(d->constants);
 	preprocessor->setConfiguration(d->config);
+	preprocessor->setImportCache(d->importCache);
 	passes.push_back(preprocessor);
 	if (verbose) {
 		auto stringVisitor = new LILToStringVisitor();
@@ -470,6 +480,15 @@ void LILCodeUnit::runPasses()
 		passes.push_back(stringVisitor);
 	}
 
+	//constant folding, before string functions are lowered so that constant pieces fold away
+	auto constantFolder = new LILConstantFolder();
+	passes.push_back(constantFolder);
+	if (verbose) {
+		auto stringVisitor = new LILToStringVisitor();
+		stringVisitor->setPrintHeadline(false);
+		passes.push_back(stringVisitor);
+	}
+
 	//string function lowering
 	auto stringFnLowerer = new LILStringFnLowerer();
 	passes.push_back(stringFnLowerer);
@@ -515,15 +534,6 @@ void LILCodeUnit::runPasses()
 		passes.push_back(stringVisitor);
 	}
 
-	//constant folding
-	auto constantFolder = new LILConstantFolder();
-	passes.push_back(constantFolder);
-	if (verbose) {
-		auto stringVisitor = new LILToStringVisitor();
-		stringVisitor->setPrintHeadline(false);
-		passes.push_back(stringVisitor);
-	}
-
 	//name lowering
 	auto nameLowerer = new LILNameLowerer();
 	passes.push_back(nameLowerer);
@@ -551,6 +561,16 @@ void LILCodeUnit::runPasses()
 		passes.push_back(stringVisitor);
 	}
 	
+	//dead code elimination
+	auto deadCodeEliminator = new LILDeadCodeEliminator();
+	deadCodeEliminator->setKeepExported(!d->isMain);
+	passes.push_back(deadCodeEliminator);
+	if (verbose) {
+		auto stringVisitor = new LILToStringVisitor();
+		stringVisitor->setPrintHeadline(false);
+		passes.push_back(stringVisitor);
+	}
+
 	//resource gathering
 	auto resourceGatherer = new LILResourceGatherer();
 	passes.push_back(resourceGatherer);
@@ -569,6 +589,9 @@ void LILCodeUnit::runPasses()
 		for (const auto & resource : importedResources) {
 			this->addResource(resource);
 		}
+		for (const auto & sourceFile : preprocessor->getSourceFiles()) {
+			this->addSourceFile(sourceFile);
+		}
 		const auto & localResources = resourceGatherer->gatherResources();
 		for (const auto & resource : localResources) {
 			this->addResource(resource);
@@ -625,6 +648,7 @@ void LILCodeUnit::runPassesForNeeds()
 	preprocessor->setSuffix(d->suffix);
 	preprocessor->setConstants(d->constants);
 	preprocessor->setConfiguration(d->config);
+	preprocessor->setImportCache(d->importCache);
 	passes.push_back(preprocessor);
 	if (verbose) {
 		auto stringVisitor = new LILToStringVisitor();
@@ -726,6 +750,9 @@ void LILCodeUnit::runPassesForNeeds()
 			for (const auto & resource : resources) {
 				this->addResource(resource);
 			}
+			for (const auto & sourceFile : preprocessor->getSourceFiles()) {
+				this->addSourceFile(sourceFile);
+			}
 			this->setDOM(domBuilder->getDOM());
 	}
 	for (auto pass : passes) {
@@ -778,6 +805,7 @@ void LILCodeUnit::runPassesForImport()
 	preprocessor->setSuffix(d->suffix);
 	preprocessor->setConstants(d->constants);
 	preprocessor->setConfiguration(d->config);
+	preprocessor->setImportCache(d->importCache);
 	passes.push_back(preprocessor);
 	if (verbose) {
 		auto stringVisitor = new LILToStringVisitor();
@@ -800,6 +828,9 @@ void LILCodeUnit::runPassesForImport()
 	for (const auto & resource : resources) {
 		this->addResource(resource);
 	}
+	for (const auto & sourceFile : preprocessor->getSourceFiles()) {
+		this->addSourceFile(sourceFile);
+	}
 
 	if (d->pm->hasErrors()) {
 		std::cerr << "Errors encountered. Exiting.\n\n";
@@ -905,6 +936,18 @@ const std::vector<LILString> & LILCodeUnit::getResources() const
 	return d->resources;
 }
 
+void LILCodeUnit::addSourceFile(const LILString & path)
+{
+	if (std::find(d->sourceFiles.begin(), d->sourceFiles.end(), path) == d->sourceFiles.end()) {
+		d->sourceFiles.push_back( path );
+	}
+}
+
+const std::vector<LILString> & LILCodeUnit::getSourceFiles() const
+{
+	return d->sourceFiles;
+}
+
 const std::shared_ptr<LILElement> & LILCodeUnit::getDOM() const
 {
 	return d->dom;
@@ -27,6 +27,7 @@ namespace LIL
 	class LILCodeUnitPrivate;
 	class LILConfiguration;
 	class LILElement;
+	class LILImportCache;
 	class LILNode;
 	class LILRootNode;
 	class LILCodeUnit
@@ -59,6 +60,7 @@ namespace LIL
 		void setConstants(const std::vector<LILString> & values);
 		void setImports(const std::vector<LILString> & values);
 		void setConfiguration(LILConfiguration * value);
+		void setImportCache(LILImportCache * value);
 
 		void run();
 		void buildAST();
@@ -83,6 +85,8 @@ namespace LIL
 		const std::vector<std::pair<LILString, bool>> & getNeededFilesForBuild() const;
 		void addResource(const LILString & path);
 		const std::vector<LILString> & getResources() const;
+		void addSourceFile(const LILString & path);
+		const std::vector<LILString> & getSourceFiles() const;
 		const std::shared_ptr<LILElement> & getDOM() const;
 		void setDOM(const std::shared_ptr<LILElement> & dom);
 
@@ -77,7 +77,21 @@ const std::string LILConfiguration::getConfigString(const std::string &name) con
 
 long int LILConfiguration::getConfigInt(const std::string &name) const
 {
-	//fixme
+	if (this->_values.count(name)) {
+		auto & vals = this->_values.at(name);
+		if (vals.size() > 0) {
+			auto lastVal = vals.back();
+			switch (lastVal->getNodeType()) {
+				case NodeTypeNumberLiteral:
+				{
+					auto numVal = std::static_pointer_cast<LILNumberLiteral>(lastVal);
+					return numVal->getValue().toLong();
+				}
+				default:
+					break;
+			}
+		}
+	}
 	return 0;
 }
 
@@ -182,6 +196,24 @@ void LILConfiguration::printConfig() const
 	}
 }
 
+std::string LILConfiguration::getFingerprint() const
+{
+	std::vector<std::string> names;
+	for (const auto & value : this->_values) {
+		names.push_back(value.first);
+	}
+	std::sort(names.begin(), names.end());
+	std::string ret;
+	for (const auto & name : names) {
+		ret += name + ":";
+		for (const auto & val : this->_values.at(name)) {
+			ret += LILNodeToString::stringify(val.get()).data() + ",";
+		}
+		ret += ";";
+	}
+	return ret;
+}
+
 std::string LILConfiguration::extractString(std::shared_ptr<LILNode> val) const
 {
 	switch (val->getNodeType()) {
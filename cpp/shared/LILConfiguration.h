@@ -34,6 +34,7 @@ namespace LIL {
 		void setConfig(const std::string & name, std::shared_ptr<LILNode> value);
 		void addConfig(const std::string & name, std::shared_ptr<LILNode> value);
 		void printConfig() const;
+		std::string getFingerprint() const;
 		std::string extractString(std::shared_ptr<LILNode> val) const;
 	private:
 		std::unordered_map<std::string, std::vector<std::shared_ptr<LILNode>>> _values;
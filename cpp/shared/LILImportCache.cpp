@@ -0,0 +1,159 @@
+/********************************************************************
+ *
+ *	  LIL Is a Language
+ *
+ *	  AUTHORS: Miro Keller
+ *
+ *	  COPYRIGHT: ©2020-today:  All Rights Reserved
+ *
+ *	  LICENSE: see LICENSE file
+ *
+ *	  This file keeps already parsed imports around between builds
+ *
+ ********************************************************************/
+
+#include "LILImportCache.h"
+#include "LILNode.h"
+
+#include <sys/stat.h>
+
+using namespace LIL;
+
+LILImportCache::LILImportCache()
+{
+	
+}
+
+LILImportCache::~LILImportCache()
+{
+	
+}
+
+void LILImportCache::setConfigKey(const std::string & value)
+{
+	//results of #if #getConfig() depend on the configuration, so a
+	//different configuration means nothing in the cache can be reused
+	if (value != this->_configKey) {
+		this->_entries.clear();
+		this->_configKey = value;
+	}
+}
+
+std::string LILImportCache::makeKey(const LILString & path, bool isNeeds, const LILString & suffix, const std::vector<LILString> & constants, const std::vector<LILString> & alreadyImported) const
+{
+	std::string key = path.data();
+	key += isNeeds ? "|needs|" : "|import|";
+	key += suffix.data();
+	for (const auto & constant : constants) {
+		key += "|" + constant.data();
+	}
+	//files the importer already has are skipped inside the import, which changes the result
+	for (const auto & importedPath : alreadyImported) {
+		key += "|imported:" + importedPath.data();
+	}
+	return key;
+}
+
+bool LILImportCache::get(
+	const std::string & key,
+	std::vector<std::shared_ptr<LILNode>> & nodes,
+	std::vector<std::pair<LILString, bool>> & neededFiles,
+	std::vector<LILString> & resources,
+	std::vector<LILString> & sourceFiles
+) const {
+	auto it = this->_entries.find(key);
+	if (it == this->_entries.end()) {
+		return false;
+	}
+	const auto & entry = it->second;
+	if (!LILImportCache::_isUpToDate(entry)) {
+		return false;
+	}
+	//the passes modify the nodes in place, so always hand out copies
+	for (const auto & node : entry.nodes) {
+		nodes.push_back(node->clone());
+	}
+	neededFiles.insert(neededFiles.end(), entry.neededFiles.begin(), entry.neededFiles.end());
+	resources.insert(resources.end(), entry.resources.begin(), entry.resources.end());
+	for (const auto & sourceFile : entry.sourceFiles) {
+		sourceFiles.push_back(sourceFile.first);
+	}
+	return true;
+}
+
+void LILImportCache::set(
+	const std::string & key,
+	const std::vector<LILString> & sourceFiles,
+	const std::vector<std::shared_ptr<LILNode>> & nodes,
+	const std::vector<std::pair<LILString, bool>> & neededFiles,
+	const std::vector<LILString> & resources
+) {
+	Entry entry;
+	for (const auto & sourceFile : sourceFiles) {
+		const auto & path = sourceFile.data();
+		entry.sourceFiles.push_back({ path, LILImportCache::_getModificationTime(path) });
+	}
+	for (const auto & node : nodes) {
+		entry.nodes.push_back(node->clone());
+	}
+	entry.neededFiles = neededFiles;
+	entry.resources = resources;
+	this->_entries[key] = std::move(entry);
+}
+
+std::vector<std::string> LILImportCache::checkForChanges()
+{
+	std::vector<std::string> changed;
+	for (auto it = this->_entries.begin(); it != this->_entries.end(); ) {
+		bool entryChanged = false;
+		for (const auto & sourceFile : it->second.sourceFiles) {
+			if (LILImportCache::_getModificationTime(sourceFile.first) != sourceFile.second) {
+				if (std::find(changed.begin(), changed.end(), sourceFile.first) == changed.end()) {
+					changed.push_back(sourceFile.first);
+				}
+				entryChanged = true;
+			}
+		}
+		if (entryChanged) {
+			it = this->_entries.erase(it);
+		} else {
+			++it;
+		}
+	}
+	return changed;
+}
+
+void LILImportCache::clear()
+{
+	this->_entries.clear();
+}
+
+size_t LILImportCache::size() const
+{
+	return this->_entries.size();
+}
+
+bool LILImportCache::_isUpToDate(const Entry & entry)
+{
+	for (const auto & sourceFile : entry.sourceFiles) {
+		if (LILImportCache::_getModificationTime(sourceFile.first) != sourceFile.second) {
+			return false;
+		}
+	}
+	return true;
+}
+
+long long LILImportCache::_getModificationTime(const std::string & path)
+{
+	struct stat buffer;
+	if (stat(path.c_str(), &buffer) != 0) {
+		return -1;
+	}
+#if defined(__APPLE__)
+	return (buffer.st_mtimespec.tv_sec * 1000000000LL) + buffer.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+	return buffer.st_mtime;
+#else
+	return (buffer.st_mtim.tv_sec * 1000000000LL) + buffer.st_mtim.tv_nsec;
+#endif
+}
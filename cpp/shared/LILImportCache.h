@@ -0,0 +1,66 @@
+/********************************************************************
+ *
+ *	  LIL Is a Language
+ *
+ *	  AUTHORS: Miro Keller
+ *
+ *	  COPYRIGHT: ©2020-today:  All Rights Reserved
+ *
+ *	  LICENSE: see LICENSE file
+ *
+ *	  This file keeps already parsed imports around between builds
+ *
+ ********************************************************************/
+
+#ifndef LILIMPORTCACHE_H
+#define LILIMPORTCACHE_H
+
+#include "LILShared.h"
+
+namespace LIL {
+	class LILNode;
+
+	class LILImportCache {
+	public:
+		LILImportCache();
+		~LILImportCache();
+
+		void setConfigKey(const std::string & value);
+		std::string makeKey(const LILString & path, bool isNeeds, const LILString & suffix, const std::vector<LILString> & constants, const std::vector<LILString> & alreadyImported) const;
+
+		bool get(
+			const std::string & key,
+			std::vector<std::shared_ptr<LILNode>> & nodes,
+			std::vector<std::pair<LILString, bool>> & neededFiles,
+			std::vector<LILString> & resources,
+			std::vector<LILString> & sourceFiles
+		) const;
+		void set(
+			const std::string & key,
+			const std::vector<LILString> & sourceFiles,
+			const std::vector<std::shared_ptr<LILNode>> & nodes,
+			const std::vector<std::pair<LILString, bool>> & neededFiles,
+			const std::vector<LILString> & resources
+		);
+
+		std::vector<std::string> checkForChanges();
+		void clear();
+		size_t size() const;
+
+	private:
+		struct Entry {
+			//the imported file and everything it imported in turn, with their modification times
+			std::vector<std::pair<std::string, long long>> sourceFiles;
+			std::vector<std::shared_ptr<LILNode>> nodes;
+			std::vector<std::pair<LILString, bool>> neededFiles;
+			std::vector<LILString> resources;
+		};
+		std::unordered_map<std::string, Entry> _entries;
+		std::string _configKey;
+
+		static long long _getModificationTime(const std::string & path);
+		static bool _isUpToDate(const Entry & entry);
+	};
+}
+
+#endif /* LILIMPORTCACHE_H */
@@ -0,0 +1,317 @@
+/********************************************************************
+ *
+ *	  LIL Is a Language
+ *
+ *	  AUTHORS: Miro Keller
+ *
+ *	  COPYRIGHT: ©2020-today:  All Rights Reserved
+ *
+ *	  LICENSE: see LICENSE file
+ *
+ *	  This file implements the compiler server and its thin client,
+ *	  which talk to each other over a local unix socket
+ *
+ ********************************************************************/
+
+#include "LILServer.h"
+#include "LILImportCache.h"
+
+#include <array>
+#include <cerrno>
+#include <cstdio>
+
+#if !defined(_WIN32)
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+//the request is the working directory followed by the arguments, one per line,
+//terminated by an empty line. The response is the output of the build followed
+//by a line with the exit code
+#define LIL_SERVER_EXIT_MARKER "\nLIL_SERVER_EXIT:"
+#define LIL_SERVER_STOP_COMMAND "--stopServer"
+#define LIL_SERVER_WATCH_INTERVAL 500
+
+using namespace LIL;
+
+LILServer::LILServer()
+: _importCache(nullptr)
+, _verbose(false)
+{
+	this->_socketPath = LILServer::getDefaultSocketPath();
+}
+
+LILServer::~LILServer()
+{
+	
+}
+
+std::string LILServer::getDefaultSocketPath()
+{
+#if defined(_WIN32)
+	return "";
+#else
+	return "/tmp/lil-server-" + std::to_string(getuid()) + ".sock";
+#endif
+}
+
+void LILServer::setSocketPath(const std::string & value)
+{
+	this->_socketPath = value;
+}
+
+void LILServer::setVerbose(bool value)
+{
+	this->_verbose = value;
+}
+
+void LILServer::setHandler(Handler handler)
+{
+	this->_handler = handler;
+}
+
+void LILServer::setImportCache(LILImportCache * value)
+{
+	this->_importCache = value;
+}
+
+#if defined(_WIN32)
+
+int LILServer::run()
+{
+	std::cerr << "Error: the compiler server is not supported on this platform.\n";
+	return -1;
+}
+
+int LILServer::runClient(const std::vector<std::string> & args, const std::string & cwd) const
+{
+	std::cerr << "Error: the compiler server is not supported on this platform.\n";
+	return -1;
+}
+
+#else
+
+//everything the build prints goes back to the client: std::cerr and std::cout, but also
+//what LLVM and printf write straight to the file descriptors (diagnostics, IR, the output
+//of programs run in the JIT), so stdout and stderr are pointed at a temporary file meanwhile
+int LILServer::_serve(const std::vector<std::string> & args, const std::string & cwd, std::string & output)
+{
+	FILE * outputFile = tmpfile();
+	if (!outputFile) {
+		//at least keep what goes through the streams
+		std::stringstream outputStream;
+		auto oldCerr = std::cerr.rdbuf(outputStream.rdbuf());
+		auto oldCout = std::cout.rdbuf(outputStream.rdbuf());
+		int exitCode = this->_handler(args, cwd);
+		std::cerr.rdbuf(oldCerr);
+		std::cout.rdbuf(oldCout);
+		output = outputStream.str();
+		return exitCode;
+	}
+
+	std::cout.flush();
+	std::cerr.flush();
+	fflush(stdout);
+	fflush(stderr);
+	int oldStdout = dup(STDOUT_FILENO);
+	int oldStderr = dup(STDERR_FILENO);
+	dup2(fileno(outputFile), STDOUT_FILENO);
+	dup2(fileno(outputFile), STDERR_FILENO);
+
+	int exitCode = this->_handler(args, cwd);
+
+	std::cout.flush();
+	std::cerr.flush();
+	fflush(stdout);
+	fflush(stderr);
+	dup2(oldStdout, STDOUT_FILENO);
+	dup2(oldStderr, STDERR_FILENO);
+	close(oldStdout);
+	close(oldStderr);
+
+	output.clear();
+	rewind(outputFile);
+	std::array<char, 1024> buffer;
+	size_t readSize;
+	while ((readSize = fread(buffer.data(), 1, buffer.size(), outputFile)) > 0) {
+		output.append(buffer.data(), readSize);
+	}
+	fclose(outputFile);
+	return exitCode;
+}
+
+int LILServer::run()
+{
+	if (this->_socketPath.length() >= sizeof(sockaddr_un::sun_path)) {
+		std::cerr << "Error: the socket path " << this->_socketPath << " is too long.\n";
+		return -1;
+	}
+	int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenFd < 0) {
+		std::cerr << "Error: could not create the server socket.\n";
+		return -1;
+	}
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, this->_socketPath.c_str(), sizeof(addr.sun_path) - 1);
+	unlink(this->_socketPath.c_str());
+	if (bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+		std::cerr << "Error: could not bind the server socket to " << this->_socketPath << ".\n";
+		close(listenFd);
+		return -1;
+	}
+	if (listen(listenFd, 8) < 0) {
+		std::cerr << "Error: could not listen on " << this->_socketPath << ".\n";
+		close(listenFd);
+		unlink(this->_socketPath.c_str());
+		return -1;
+	}
+	std::cerr << "LIL compiler server listening on " << this->_socketPath << "\n";
+
+	bool running = true;
+	while (running) {
+		pollfd pfd;
+		pfd.fd = listenFd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		int pollResult = poll(&pfd, 1, LIL_SERVER_WATCH_INTERVAL);
+		if (pollResult < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			std::cerr << "Error: poll() failed on the server socket.\n";
+			break;
+		}
+		if (pollResult == 0) {
+			//nothing to do, so look if any of the source files we know about were touched
+			if (this->_importCache) {
+				for (const auto & changedFile : this->_importCache->checkForChanges()) {
+					if (this->_verbose) {
+						std::cerr << "File changed: " << changedFile << "\n";
+					}
+				}
+			}
+			continue;
+		}
+		int clientFd = accept(listenFd, nullptr, nullptr);
+		if (clientFd < 0) {
+			continue;
+		}
+
+		std::string request;
+		std::array<char, 1024> buffer;
+		while (request.find("\n\n") == std::string::npos) {
+			ssize_t readSize = read(clientFd, buffer.data(), buffer.size());
+			if (readSize <= 0) {
+				break;
+			}
+			request.append(buffer.data(), readSize);
+		}
+		std::vector<std::string> lines;
+		std::stringstream requestStream(request);
+		std::string line;
+		while (std::getline(requestStream, line)) {
+			if (line.length() == 0) {
+				break;
+			}
+			lines.push_back(line);
+		}
+		if (lines.size() == 0) {
+			close(clientFd);
+			continue;
+		}
+		std::string cwd = lines.front();
+		std::vector<std::string> args(lines.begin() + 1, lines.end());
+
+		std::string response;
+		int exitCode = 0;
+		if (args.size() == 1 && args.front() == LIL_SERVER_STOP_COMMAND) {
+			response = "Stopping the LIL compiler server.\n";
+			running = false;
+		} else {
+			if (this->_verbose) {
+				std::cerr << "Serving request in " << cwd << "\n";
+			}
+			if (chdir(cwd.c_str()) != 0) {
+				response = "Error: could not change to directory " + cwd + "\n";
+				exitCode = -1;
+			} else {
+				exitCode = this->_serve(args, cwd, response);
+			}
+		}
+		response += LIL_SERVER_EXIT_MARKER + std::to_string(exitCode) + "\n";
+
+		size_t written = 0;
+		while (written < response.length()) {
+			ssize_t writeSize = write(clientFd, response.data() + written, response.length() - written);
+			if (writeSize <= 0) {
+				break;
+			}
+			written += writeSize;
+		}
+		close(clientFd);
+	}
+	close(listenFd);
+	unlink(this->_socketPath.c_str());
+	return 0;
+}
+
+int LILServer::runClient(const std::vector<std::string> & args, const std::string & cwd) const
+{
+	if (this->_socketPath.length() >= sizeof(sockaddr_un::sun_path)) {
+		std::cerr << "Error: the socket path " << this->_socketPath << " is too long.\n";
+		return -1;
+	}
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		std::cerr << "Error: could not create a socket.\n";
+		return -1;
+	}
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, this->_socketPath.c_str(), sizeof(addr.sun_path) - 1);
+	if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+		std::cerr << "Error: could not connect to the compiler server at " << this->_socketPath << ". Is it running? (start it with lil --server)\n";
+		close(fd);
+		return -1;
+	}
+
+	std::string request = cwd + "\n";
+	for (const auto & arg : args) {
+		request += arg + "\n";
+	}
+	request += "\n";
+	size_t written = 0;
+	while (written < request.length()) {
+		ssize_t writeSize = write(fd, request.data() + written, request.length() - written);
+		if (writeSize <= 0) {
+			std::cerr << "Error: could not send the request to the compiler server.\n";
+			close(fd);
+			return -1;
+		}
+		written += writeSize;
+	}
+
+	std::string response;
+	std::array<char, 1024> buffer;
+	ssize_t readSize;
+	while ((readSize = read(fd, buffer.data(), buffer.size())) > 0) {
+		response.append(buffer.data(), readSize);
+	}
+	close(fd);
+
+	int exitCode = -1;
+	size_t markerIndex = response.rfind(LIL_SERVER_EXIT_MARKER);
+	if (markerIndex != std::string::npos) {
+		exitCode = std::stoi(response.substr(markerIndex + strlen(LIL_SERVER_EXIT_MARKER)));
+		response = response.substr(0, markerIndex);
+	}
+	std::cerr << response;
+	return exitCode;
+}
+
+#endif
@@ -0,0 +1,52 @@
+/********************************************************************
+ *
+ *	  LIL Is a Language
+ *
+ *	  AUTHORS: Miro Keller
+ *
+ *	  COPYRIGHT: ©2020-today:  All Rights Reserved
+ *
+ *	  LICENSE: see LICENSE file
+ *
+ *	  This file implements the compiler server and its thin client,
+ *	  which talk to each other over a local unix socket
+ *
+ ********************************************************************/
+
+#ifndef LILSERVER_H
+#define LILSERVER_H
+
+#include "LILShared.h"
+
+#include <functional>
+
+namespace LIL {
+	class LILImportCache;
+
+	class LILServer {
+	public:
+		typedef std::function<int(const std::vector<std::string> & args, const std::string & cwd)> Handler;
+
+		LILServer();
+		~LILServer();
+
+		static std::string getDefaultSocketPath();
+		void setSocketPath(const std::string & value);
+		void setVerbose(bool value);
+		void setHandler(Handler handler);
+		void setImportCache(LILImportCache * value);
+
+		int run();
+		int runClient(const std::vector<std::string> & args, const std::string & cwd) const;
+
+	private:
+		int _serve(const std::vector<std::string> & args, const std::string & cwd, std::string & output);
+
+		std::string _socketPath;
+		Handler _handler;
+		LILImportCache * _importCache;
+		bool _verbose;
+	};
+}
+
+#endif /* LILSERVER_H */
@@ -185,6 +185,10 @@ namespace LIL
 		FunctionCallTypeSet,
 		FunctionCallTypeSizeOf,
 		FunctionCallTypeConversion,
+		//the vector builtins, told apart by name (see LILFunctionCall::isSIMDBuiltin)
+		FunctionCallTypeSIMD,
+		//atomic memory operations, told apart by name (see LILFunctionCall::isAtomicBuiltin)
+		FunctionCallTypeAtomic,
 	};
 
 	enum FlowControlType
@@ -237,6 +241,10 @@ namespace LIL
 		InstructionTypeExpand,
 		InstructionTypeGPU,
 		InstructionTypeResource,
+		InstructionTypeUnroll,
+		InstructionTypeVectorize,
+		InstructionTypeIndependent,
+		InstructionTypeParallel,
 	};
 
 	enum SelectorType
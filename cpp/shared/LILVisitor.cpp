@@ -300,6 +300,13 @@ std::shared_ptr<LILNode> LILVisitor::findNodeForValuePath(LILValuePath * vp) con
 							auto saTy = std::static_pointer_cast<LILStaticArrayType>(currentTy);
 							currentTy = saTy->getType();
 						}
+					} else if (currentTy->getTypeType() == TypeTypePointer) {
+						if (isLast) {
+							return currentNode;
+						} else {
+							auto ptrTy = std::static_pointer_cast<LILPointerType>(currentTy);
+							currentTy = ptrTy->getArgument();
+						}
 					}
 					break;
 				}
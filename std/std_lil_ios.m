@@ -5,6 +5,11 @@
 #include <simd/simd.h>
 #include <math.h>
 
+//boxes, images and shapes share one vertex buffer, which is written in place every frame
+#define LIL_MAX_VERTICES 65536
+//shapes are indexed with 32 bit indices, one triangle list over all of them
+#define LIL_MAX_INDICES (LIL_MAX_VERTICES * 3)
+
 typedef struct LIL__resourceStruct {
 	char path[1024];
 	void * data;
@@ -13,9 +18,9 @@ typedef struct LIL__resourceStruct {
 
 extern void LIL__init();
 extern void LIL__nextFrame(double deltaTime);
-extern void LIL__makeBoxVertices(void * vertexBuffer, long int * vertexCount);
-extern void LIL__makeTextureVertices(void * vertexBuffer, long int * vertexCount);
-extern void LIL__makeShapeVertices(void * vertexBuffer, long int * vertexCount, void * indexBuffer, long int * indexCount);
+extern void LIL__makeBoxVertices(void * vertexBuffer, long int * vertexCount, long int vertexCapacity);
+extern void LIL__makeTextureVertices(void * vertexBuffer, long int * vertexCount, long int vertexCapacity);
+extern void LIL__makeShapeVertices(void * vertexBuffer, long int * vertexCount, long int vertexCapacity, void * indexBuffer, long int * indexCount, long int indexCapacity);
 extern long int LIL__getResourceCount();
 extern LIL__resourceStruct * LIL__getResorceById(long int id);
 extern void LIL__setTextureSize(long int imgId, double width, double height);
@@ -57,6 +62,12 @@ typedef struct
 	float textureY;
 } LILVertex;
 
+//how many vertices still fit in the vertex buffer after the given position
+static long int LIL__vertexCapacityFrom(char * vertexBufferPointer, char * position) {
+	long int used = (position - vertexBufferPointer) / (long int)sizeof(LILVertex);
+	return used < LIL_MAX_VERTICES ? LIL_MAX_VERTICES - used : 0;
+}
+
 typedef struct
 {
 	float scale;
@@ -202,10 +213,10 @@ typedef struct
 		}
 
 		//create a new empty vertex buffer
-		vertexBuffer = [device newBufferWithLength:(sizeof(LILVertex)*1000) options:MTLResourceStorageModeShared];
+		vertexBuffer = [device newBufferWithLength:(sizeof(LILVertex)*LIL_MAX_VERTICES) options:MTLResourceStorageModeShared];
 		vertexBuffer.label = @"vertexBuffer";
 		//create a new empty index buffer
-		indexBuffer = [device newBufferWithLength:(sizeof(UInt16)*8000) options:MTLResourceStorageModeShared];
+		indexBuffer = [device newBufferWithLength:(sizeof(UInt32)*LIL_MAX_INDICES) options:MTLResourceStorageModeShared];
 		indexBuffer.label = @"indexBuffer";
 
 		NSError *error;
@@ -628,16 +639,16 @@ typedef struct
 	{
 		LIL__nextFrame(deltaTime);
 		char * vertexBufferPointer = [_renderer getVertexBufferPointer];
-		LIL__makeBoxVertices((void *)vertexBufferPointer, &vertexCount);
+		LIL__makeBoxVertices((void *)vertexBufferPointer, &vertexCount, LIL_MAX_VERTICES);
 		_renderer.boxVertexCount = vertexCount;
 		char * textureVtxBufferPtr = (char *)LIL__roundUp((long int)(vertexBufferPointer + (vertexCount * sizeof(LILVertex))), 256);
-		LIL__makeTextureVertices((void *)textureVtxBufferPtr, &textureVertexCount);
+		LIL__makeTextureVertices((void *)textureVtxBufferPtr, &textureVertexCount, LIL__vertexCapacityFrom(vertexBufferPointer, textureVtxBufferPtr));
 		_renderer.textureVertexCount = textureVertexCount;
 		long int shapeVertexCount = 0;
 		long int shapeIndexCount = 0;
 		char * indexBufferPointer = [_renderer getIndexBufferPointer];
 		char * shapeVtxBufferPtr = (char *)LIL__roundUp((long int)textureVtxBufferPtr + (textureVertexCount * sizeof(LILVertex)), 256);
-		LIL__makeShapeVertices((void *)shapeVtxBufferPtr, &shapeVertexCount, (void *)indexBufferPointer, &shapeIndexCount);
+		LIL__makeShapeVertices((void *)shapeVtxBufferPtr, &shapeVertexCount, LIL__vertexCapacityFrom(vertexBufferPointer, shapeVtxBufferPtr), (void *)indexBufferPointer, &shapeIndexCount, LIL_MAX_INDICES);
 		_renderer.shapeVertexCount = shapeVertexCount;
 		_renderer.shapeIndexCount = shapeIndexCount;
 	}
@@ -866,6 +877,7 @@ LILAppDelegate * LIL__applicationDelegate;
 
 - (void)applicationWillTerminate:(UIApplication *)application {
 	// Called when the application is about to terminate. Save data if appropriate. See also applicationDidEnterBackground:.
+	msgEmit("onTerminate", NULL);
 }
 
 - (CGSize)getUIWindowSize {